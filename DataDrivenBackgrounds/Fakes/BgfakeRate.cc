@@ -68,7 +68,8 @@ To do's
 #include "../../Include/TElectron.hh"
 #include "../../Include/TVertex.hh"
 
-#include "TreeQueue.hh"
+#include "ConfList.hh"
+#include "LazyEvent.hh"
 
 // lumi section selection with JSON files
 // #include "RunLumiRangeMap.h"
@@ -106,89 +107,6 @@ using std::make_pair;
 using boost::scoped_ptr;
 using boost::shared_ptr;
 
-//===============================================
-//conflist class
-//=================================================
-//need to put this in its own .cc and .hh file
-
-class ConfList : public TreeQueue{
-  public:
-  ConfList(string listOfRootFiles);
-  bool nextFile(); //method to jump to next file
-  void reset();
-  double getVal() const {return *current_xsec;}
-
-  private:
-  vector<double> xseclist;
-  vector<double>::iterator xsec_iter;
-  bool storeFilenames();
-  vector<double>::iterator current_xsec;
-};
-
-
-ConfList::ConfList(string listOfRootFiles): TreeQueue(listOfRootFiles, true){
-  if (storeFilenames()){//anyfilenames stored?
-    reset();//Then point to the first file
-  } else {
-    //should I throw an exception
-    throw "empty list of files";
-  }
-}
-
-bool ConfList::storeFilenames(){  
-  string line;
-  xseclist.clear();//clear vector
-  filelist.clear();//clear vector
-  while (rootFileStream.good()){
-    getline(rootFileStream,line);
-    if (line[0] != '#'){//ignore comment lines
-      if (line.size() != 0) {//ignore empty lines
-	istringstream concat(line);
-	string rootfile;
-	double xsec;
-	concat >> rootfile >> xsec;
-	filelist.push_back(rootfile);
-        xseclist.push_back(xsec);
-      }
-    }
-  }
-  //need to clear file for reuse
-  rootFileStream.clear();
-
-  if (filelist.size() != xseclist.size()){
-    throw "size mismatch";
-  }
-
-  if (!filelist.empty()) {//same as checking if xseclist is empty
-    return true;
-  } else {
-    return false;
-  }
-}
-
-bool ConfList::nextFile(){
-  bool outcome;
-  if (TreeQueue::nextFile()){
-    if (xsec_iter != xseclist.end()){
-      current_xsec = xsec_iter;
-      ++xsec_iter;
-      outcome = true;
-    } else {
-      outcome = false;
-    }
-  } else {
-    outcome = false;
-  }
-
-  return outcome;
-}
-
-void ConfList::reset(){
-  TreeQueue::reset();
-  xsec_iter = xseclist.begin();
-  current_xsec =  xsec_iter;
-}
-
 //============================
 //Simple class to hold two values
 //Class value does not change if value order is changed
@@ -227,7 +145,8 @@ template <typename T> bool Couple<T>::operator!=(const Couple& rhs) const{
 
 //=== MAIN MACRO =================================================================================================
 
-void BgfakeRate() 
+// nPrefetch, readAheadMB: prefetching of the input files (see TreeQueue.hh)
+void BgfakeRate(unsigned int nPrefetch=1, int readAheadMB=0) 
 {  
   gBenchmark->Start("BgfakeRate");
 
@@ -362,7 +281,17 @@ void BgfakeRate()
   avoids creating temporaries but not easy to decipher, hence the explanation */
  
   // look at MC events identified as fakes
-  ConfList fakeTrees("BgfakeR.txt");  
+  ConfList fakeTrees("BgfakeR.txt", nPrefetch, Long64_t(readAheadMB)*1048576);  
+
+  // The branches are read on the first access in the event. Info is not
+  // used by the selection below and is not read
+  LazyBranch<mithep::TEventInfo> evInfo("Info", info);
+  LazyBranch<TClonesArray> evDielectrons("Dielectron", diElectronArr);
+  LazyEvent bgEvent;
+  bgEvent.add(evInfo);
+  bgEvent.add(evDielectrons);
+  CutFlow bgFlow("MC backgrounds");
+  const unsigned int cutDielectron = bgFlow.declare("has dielectron");     // Dielectron
 
    //start from first file again
   fakeTrees.reset();
@@ -374,8 +303,7 @@ void BgfakeRate()
     double xsec = fakeTrees.getVal();    
 
     // Set branch address to structures that will store the info  
-    eventTree->SetBranchAddress("Info",       &info);          TBranch *infoBr       = eventTree->GetBranch("Info");
-    eventTree->SetBranchAddress("Dielectron" ,  &diElectronArr  ); TBranch *diElectronBr   = eventTree->GetBranch("Dielectron");    
+    bgEvent.attach(eventTree);
 
     double mcScaleFactor(1.0);
     UInt_t maxEvents = eventTree->GetEntries();
@@ -384,11 +312,11 @@ void BgfakeRate()
     for(UInt_t ientry=0; ientry<maxEvents; ++ientry) {           
       if(ientry >= maxEvents) break;	
     
-      infoBr->GetEntry(ientry);	
-      diElectronArr->Clear(); 
-      diElectronBr->GetEntry(ientry);	
+      bgEvent.setEntry(ientry);
+      bgFlow.beginEvent();
 
-      UInt_t maxDiElectrons = diElectronArr->GetEntriesFast();
+      UInt_t maxDiElectrons = evDielectrons->GetEntriesFast();
+      if (!bgFlow.pass(cutDielectron, maxDiElectrons > 0)) continue;
 
       map<Float_t,UInt_t> elecEMap;
       map<Float_t,UInt_t> elecCandEMap;
@@ -588,6 +516,9 @@ void BgfakeRate()
 
     }//end of loop over events
   }//end of loop over files
+  fakeTrees.printTimings();
+  bgFlow.print();
+  bgEvent.printStats();
 
   //Set current output file
   outFile->cd();
@@ -9,7 +9,8 @@ using std::istringstream;
 //================================
 
 
-ConfList::ConfList(string listOfRootFiles): TreeQueue(listOfRootFiles, true){
+ConfList::ConfList(string listOfRootFiles, unsigned int nPrefetch, Long64_t readAheadBytes):
+  TreeQueue(listOfRootFiles, true, nPrefetch, readAheadBytes){
   if (storeFilenames()){//anyfilenames stored?
     reset();//Then point to the first file
   } else {
@@ -10,7 +10,7 @@
 
 class ConfList : public TreeQueue{
   public:
-  ConfList(string listOfRootFiles);
+  ConfList(string listOfRootFiles, unsigned int nPrefetch=1, Long64_t readAheadBytes=0);
   bool nextFile(); //method to jump to next file
   void reset();
   double getVal() const {return *current_xsec;}
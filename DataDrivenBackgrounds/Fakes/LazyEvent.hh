@@ -0,0 +1,162 @@
+#ifndef LAZYEVENT_HH
+#define LAZYEVENT_HH
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdio.h>
+#include <time.h>                   // clock_gettime
+#include <assert.h>
+
+#include <TTree.h>                  // class to access ntuples
+#include <TBranch.h>
+#include <TClonesArray.h>           // ROOT array class
+
+using std::vector;
+using std::string;
+
+//===============================================================================
+//Lazy reading of the event branches and a cut flow with per-cut timing
+//
+//A LazyBranch reads its branch at the first access within an entry, thus
+//a branch used only after the cheap cuts is not decompressed for the
+//rejected events. LazyEvent moves all its branches to the next entry.
+//
+//The cuts of a CutFlow are declared once and tested in the declared
+//order. The time since the previous test (or since beginEvent) is
+//attributed to the cut, including the branch reads triggered by it
+//==============================================================================
+
+class LazyBranchBase{
+  public:
+  LazyBranchBase(const string &name) : branchName(name), branch(0), entry(-1), loadedEntry(-1), nReads(0) {}
+  virtual ~LazyBranchBase(){}
+  virtual void attach(TTree *tree) = 0;
+  void setEntry(Long64_t set_entry){ entry=set_entry; }
+  const string& name() const { return branchName; }
+  Long64_t reads() const { return nReads; }
+
+  protected:
+  string branchName;
+  TBranch *branch;
+  Long64_t entry, loadedEntry, nReads;
+};
+
+//the arrays are cleared before reading, the other objects are overwritten
+inline void lazyBranchClear(TClonesArray *arr){ arr->Clear(); }
+inline void lazyBranchClear(TObject *){}
+
+template<class T>
+class LazyBranch : public LazyBranchBase{
+  public:
+  //obj is the pointer the macro uses, its address is given to the tree
+  LazyBranch(const string &name, T* &set_obj) : LazyBranchBase(name), obj(set_obj) {}
+
+  void attach(TTree *tree){
+    tree->SetBranchAddress(branchName.c_str(), &obj);
+    branch = tree->GetBranch(branchName.c_str());
+    assert(branch);
+    loadedEntry = -1;
+  }
+
+  T* get(){
+    if (loadedEntry != entry){
+      lazyBranchClear(obj);
+      branch->GetEntry(entry);
+      loadedEntry = entry;
+      ++nReads;
+    }
+    return obj;
+  }
+  T* operator->(){ return get(); }
+
+  private:
+  T* &obj;
+};
+
+//===============================================================================
+
+class LazyEvent{
+  public:
+  LazyEvent() : branches(), nEntries(0) {}
+  void add(LazyBranchBase &b){ branches.push_back(&b); }
+  void attach(TTree *tree){
+    for (unsigned int i=0; i<branches.size(); ++i) branches[i]->attach(tree);
+  }
+  void setEntry(Long64_t entry){
+    ++nEntries;
+    for (unsigned int i=0; i<branches.size(); ++i) branches[i]->setEntry(entry);
+  }
+  void printStats() const{
+    for (unsigned int i=0; i<branches.size(); ++i){
+      printf("   branch %-12s read for %10lld of %10lld entries (%5.1lf%%)\n",
+	     branches[i]->name().c_str(), branches[i]->reads(), nEntries,
+	     (nEntries) ? 100.*branches[i]->reads()/double(nEntries) : 0.);
+    }
+  }
+
+  private:
+  vector<LazyBranchBase*> branches;
+  Long64_t nEntries;
+};
+
+//===============================================================================
+
+class CutFlow{
+  public:
+  CutFlow(const string &set_name) : flowName(set_name), cutNames(), nTested(), nPassed(), cutTime(), nEvents(0), mark(0), lastCut(0) {}
+
+  unsigned int declare(const string &cutName){
+    cutNames.push_back(cutName);
+    nTested.push_back(0);
+    nPassed.push_back(0);
+    cutTime.push_back(0.);
+    return cutNames.size()-1;
+  }
+
+  void beginEvent(){
+    ++nEvents;
+    mark = now();
+    lastCut = 0;
+  }
+
+  //records the outcome of the cut and returns it
+  bool pass(unsigned int icut, bool result){
+    assert((icut < cutNames.size()) && (icut >= lastCut)); //declared order
+    const double t = now();
+    cutTime[icut] += t - mark;
+    mark = t;
+    lastCut = icut;
+    ++nTested[icut];
+    if (result) ++nPassed[icut];
+    return result;
+  }
+
+  void print() const{
+    printf("Cut flow <%s>: %lld events\n", flowName.c_str(), nEvents);
+    printf("   %-20s %12s %12s %8s %10s %10s\n", "cut", "tested", "passed", "eff", "time [s]", "us/test");
+    for (unsigned int i=0; i<cutNames.size(); ++i){
+      printf("   %-20s %12lld %12lld %8.4lf %10.2lf %10.3lf\n",
+	     cutNames[i].c_str(), nTested[i], nPassed[i],
+	     (nTested[i]) ? nPassed[i]/double(nTested[i]) : 0.,
+	     cutTime[i], (nTested[i]) ? 1e6*cutTime[i]/nTested[i] : 0.);
+    }
+  }
+
+  private:
+  string flowName;
+  vector<string> cutNames;
+  vector<Long64_t> nTested, nPassed;
+  vector<double> cutTime;
+  Long64_t nEvents;
+  double mark;
+  unsigned int lastCut;
+
+  static double now(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9*ts.tv_nsec;
+  }
+};
+
+#endif
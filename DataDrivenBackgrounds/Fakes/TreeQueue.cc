@@ -1,15 +1,34 @@
-
 #include "TreeQueue.hh"
 #include <iostream>                 // stl iostream
 #include <assert.h>                 // assert
+#include <stdio.h>                  // read-ahead of the files
+#include <TThread.h>                // background opening of the files
+#include <TStopwatch.h>             // timings
+#include <TDirectory.h>
 
 using std::cout;
 
+//TFile opening and closing is serialized between the threads
+TMutex treeQueueFileMutex;
+
 //=================
 //Class definitions
 //=================
 
-TreeQueue::TreeQueue(string listOfRootFiles){ 
+TreeQueue::TreeQueue() :
+  filelist(), evtTree(NULL), infile(NULL), currentIdx(-1), nextIdx(0),
+  nPrefetch(0), readAheadBytes(0), files(), fileState(), fileStat(),
+  mutex(), fileOpened(&mutex), prefetchThread(NULL),
+  prefetchRunning(false), stopPrefetch(false)
+{}
+
+TreeQueue::TreeQueue(string listOfRootFiles, unsigned int set_nPrefetch, Long64_t set_readAheadBytes) :
+  filelist(), evtTree(NULL), infile(NULL), currentIdx(-1), nextIdx(0),
+  nPrefetch(set_nPrefetch), readAheadBytes(set_readAheadBytes),
+  files(), fileState(), fileStat(),
+  mutex(), fileOpened(&mutex), prefetchThread(NULL),
+  prefetchRunning(false), stopPrefetch(false)
+{
   rootFileStream.open(listOfRootFiles.c_str(), ifstream::in);
   //Need to test if file exists. If it doesn't say so in an error
   if (storeFilenames()){//anyfilenames stored?
@@ -20,44 +39,96 @@ TreeQueue::TreeQueue(string listOfRootFiles){
   }
 }
 
-TreeQueue::TreeQueue(string listOfRootFiles, bool isInherited){
-  //partially construct members as Derived class will do the rest 
+TreeQueue::TreeQueue(string listOfRootFiles, bool isInherited, unsigned int set_nPrefetch, Long64_t set_readAheadBytes) :
+  filelist(), evtTree(NULL), infile(NULL), currentIdx(-1), nextIdx(0),
+  nPrefetch(set_nPrefetch), readAheadBytes(set_readAheadBytes),
+  files(), fileState(), fileStat(),
+  mutex(), fileOpened(&mutex), prefetchThread(NULL),
+  prefetchRunning(false), stopPrefetch(false)
+{
+  //partially construct members as Derived class will do the rest
   rootFileStream.open(listOfRootFiles.c_str(), ifstream::in);
   isInherited = true;
 }
 
 
 TreeQueue::~TreeQueue(){
-  //delete infile; memory leak, need to implement this properly!
+  stopPrefetching();
+  closeAll();
 }
 
+//the file becomes the current one. The previous file is closed
 bool TreeQueue::nextFile(){
-  if (s_iter != filelist.end()){
-    infile = new TFile(TString(*s_iter));
-    assert(infile);
-    current = s_iter;
-    ++s_iter;
-    return true;
-  } else {
+  if (nextIdx >= int(filelist.size())) return false;
+  TStopwatch waitTimer;
+  waitTimer.Start();
+
+  //close the previous file
+  TFile *prevFile=NULL;
+  bool openHere=false;
+  const int idx=nextIdx;
+  mutex.Lock();
+  if (currentIdx>=0) {
+    prevFile=files[currentIdx];
+    files[currentIdx]=NULL;
+    fileState[currentIdx]=_fileClosed;
+  }
+  currentIdx=idx;
+  ++nextIdx;
+  if (fileState[idx]==_fileIdle) {
+    //not prefetched, open it here
+    fileState[idx]=_fileOpening;
+    openHere=true;
+  }
+  mutex.UnLock();
+  infile=NULL;
+  evtTree=NULL;
+  if (prevFile) closeFile(prevFile);
+
+  //the window of the prefetched files has moved
+  startPrefetch();
+
+  if (openHere) {
+    double openTime=0;
+    TFile *f=openFile(idx,openTime);
+    TLockGuard lock(&mutex);
+    files[idx]=f;
+    fileState[idx]=(f) ? _fileReady : _fileFailed;
+    fileStat[idx].openTime=openTime;
+    fileStat[idx].prefetched=false;
+  }
+
+  mutex.Lock();
+  while (fileState[idx]==_fileOpening) fileOpened.Wait();
+  infile=files[idx];
+  waitTimer.Stop();
+  fileStat[idx].waitTime=waitTimer.RealTime();
+  mutex.UnLock();
+
+  if (!infile) {
+    cout << "TreeQueue: failed to open <" << filelist[idx] << ">\n";
+    assert(0);
     return false;
   }
+  infile->cd();
+  return true;
 }
 
 void TreeQueue::reset(){
-  s_iter = filelist.begin();
-  infile = new TFile(TString(*s_iter));  
-  assert(infile);
-  current = s_iter;
+  stopPrefetching();
+  closeAll();
+  initFileSlots();
 }
 
 TTree* TreeQueue::getTree(const TString& treeName){
   // Get the TTree
-  evtTree = (TTree*)infile->Get(treeName); 
+  assert(infile);
+  evtTree = (TTree*)infile->Get(treeName);
   assert(evtTree);
   return evtTree;
 }
 
-bool TreeQueue::storeFilenames(){  
+bool TreeQueue::storeFilenames(){
   string line;
   filelist.clear();//clear vector
   while (rootFileStream.good()){
@@ -78,6 +149,162 @@ bool TreeQueue::storeFilenames(){
   }
 }
 
+void TreeQueue::initFileSlots(){
+  TLockGuard lock(&mutex);
+  files.assign(filelist.size(),(TFile*)NULL);
+  fileState.assign(filelist.size(),int(_fileIdle));
+  fileStat.assign(filelist.size(),TreeQueueFileStat_t());
+  currentIdx=-1;
+  nextIdx=0;
+}
+
+TFile* TreeQueue::openFile(unsigned int idx, double &openTime) const{
+  TStopwatch timer;
+  timer.Start();
+  TFile *f=NULL;
+  {
+    TLockGuard lock(&treeQueueFileMutex);
+    TDirectory *saveDir=gDirectory;
+    f=TFile::Open(TString(filelist[idx]));
+    saveDir->cd();
+  }
+  timer.Stop();
+  openTime=timer.RealTime();
+  return f;
+}
+
+void TreeQueue::closeFile(TFile *f) const{
+  TLockGuard lock(&treeQueueFileMutex);
+  delete f;
+}
+
+void TreeQueue::closeAll(){
+  vector<TFile*> toClose;
+  {
+    TLockGuard lock(&mutex);
+    for (unsigned int i=0; i<files.size(); ++i){
+      if (files[i]) toClose.push_back(files[i]);
+      files[i]=NULL;
+      if (fileState[i]!=_fileIdle) fileState[i]=_fileClosed;
+    }
+  }
+  infile=NULL;
+  evtTree=NULL;
+  for (unsigned int i=0; i<toClose.size(); ++i) closeFile(toClose[i]);
+}
+
+//=================
+//Prefetching
+//=================
+
+void* treeQueuePrefetch_local(void *arg){
+  TreeQueue *queue=(TreeQueue*)arg;
+  queue->prefetchLoop();
+  return 0;
+}
+
+int TreeQueue::nextToPrefetch() const{
+  if (stopPrefetch) return -1;
+  const int last=(nextIdx+int(nPrefetch) < int(filelist.size())) ? nextIdx+int(nPrefetch) : int(filelist.size());
+  for (int i=nextIdx; i<last; ++i){
+    if (fileState[i]==_fileIdle) return i;
+  }
+  return -1;
+}
+
+//the thread opens the files of the window and exits when there is
+//nothing left to do. nextFile() starts it again when the window moves
+void TreeQueue::startPrefetch(){
+  if (!nPrefetch) return;
+  TThread *finished=NULL;
+  {
+    TLockGuard lock(&mutex);
+    if (prefetchRunning || (nextToPrefetch()<0)) return;
+    finished=prefetchThread;
+    prefetchThread=NULL;
+    prefetchRunning=true;
+  }
+  if (finished){
+    finished->Join();
+    delete finished;
+  }
+  TThread::Initialize();
+  prefetchThread=new TThread("TreeQueuePrefetch",treeQueuePrefetch_local,(void*)this);
+  prefetchThread->Run();
+}
+
+void TreeQueue::stopPrefetching(){
+  {
+    TLockGuard lock(&mutex);
+    stopPrefetch=true;
+  }
+  if (prefetchThread){
+    prefetchThread->Join();
+    delete prefetchThread;
+    prefetchThread=NULL;
+  }
+  TLockGuard lock(&mutex);
+  stopPrefetch=false;
+  prefetchRunning=false;
+}
+
+void TreeQueue::prefetchLoop(){
+  for (;;){
+    mutex.Lock();
+    const int idx=nextToPrefetch();
+    if (idx<0){
+      prefetchRunning=false;
+      mutex.UnLock();
+      return;
+    }
+    fileState[idx]=_fileOpening;
+    mutex.UnLock();
+
+    double openTime=0;
+    TFile *f=openFile(idx,openTime);
+    mutex.Lock();
+    files[idx]=f;
+    fileState[idx]=(f) ? _fileReady : _fileFailed;
+    fileStat[idx].openTime=openTime;
+    fileStat[idx].prefetched=true;
+    fileOpened.Broadcast();
+    mutex.UnLock();
+
+    if (f && (readAheadBytes>0)) readAhead(idx);
+  }
+}
+
+//reads the beginning of a local (or NFS-mounted) file, so that the
+//baskets are in the page cache when the event loop gets to them
+void TreeQueue::readAhead(unsigned int idx){
+  if (filelist[idx].find("://")!=string::npos) return;
+  FILE *fp=fopen(filelist[idx].c_str(),"rb");
+  if (!fp) return;
+  TStopwatch timer;
+  timer.Start();
+  vector<char> buf(1<<20);
+  Long64_t total=0;
+  while (total<readAheadBytes){
+    {
+      TLockGuard lock(&mutex);
+      if (stopPrefetch) break;
+    }
+    const Long64_t left=readAheadBytes-total;
+    const size_t n=fread(&buf[0],1,(left<Long64_t(buf.size())) ? size_t(left) : buf.size(),fp);
+    if (!n) break;
+    total+=n;
+  }
+  fclose(fp);
+  timer.Stop();
+  TLockGuard lock(&mutex);
+  fileStat[idx].readAheadTime=timer.RealTime();
+  fileStat[idx].readAheadBytes=total;
+}
+
+//=================
+//Printing
+//=================
+
 void TreeQueue::printOut() const{
   for (vector<string>::const_iterator iter = filelist.begin(); iter != filelist.end(); ++iter){
     cout << *iter << "\n";
@@ -86,6 +313,43 @@ void TreeQueue::printOut() const{
   throw "End of printout \n";
 }
 
+vector<TreeQueueFileStat_t> TreeQueue::fileStats() const{
+  TLockGuard lock(&mutex);
+  return fileStat;
+}
+
 void TreeQueue::status() const{
-  cout << "Currently pointing to: " << *current << "\n";
+  if (currentIdx<0){
+    cout << "Not pointing to any file yet\n";
+    return;
+  }
+  TreeQueueFileStat_t st;
+  {
+    TLockGuard lock(&mutex);
+    st=fileStat[currentIdx];
+  }
+  cout << "Currently pointing to: " << filelist[currentIdx] << "\n";
+  printf("   opened in %6.2lf s (%s), waited %6.2lf s",
+	 st.openTime, (st.prefetched) ? "prefetched" : "on demand", st.waitTime);
+  if (st.readAheadBytes>0) printf(", read ahead %6.1lf MB in %6.2lf s", st.readAheadBytes/1048576., st.readAheadTime);
+  printf("\n");
+}
+
+void TreeQueue::printTimings() const{
+  vector<TreeQueueFileStat_t> st=fileStats();
+  double openTime=0, waitTime=0, readAheadTime=0;
+  Long64_t readAheadTotal=0;
+  int count=0, prefetchedCount=0;
+  for (int i=0; (i<int(st.size())) && (i<=currentIdx); ++i){
+    count++;
+    if (st[i].prefetched) prefetchedCount++;
+    openTime+=st[i].openTime;
+    waitTime+=st[i].waitTime;
+    readAheadTime+=st[i].readAheadTime;
+    readAheadTotal+=st[i].readAheadBytes;
+  }
+  printf("TreeQueue: %d files (%d prefetched), opening %6.2lf s, waiting %6.2lf s",
+	 count, prefetchedCount, openTime, waitTime);
+  if (readAheadTotal>0) printf(", read ahead %6.1lf MB in %6.2lf s", readAheadTotal/1048576., readAheadTime);
+  printf("\n");
 }
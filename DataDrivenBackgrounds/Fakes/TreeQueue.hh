@@ -8,41 +8,85 @@
 #include <TFile.h>                  // file handle class
 #include <TTree.h>                  // class to access ntuples
 #include <TString.h>                // ROOT string class
+#include <TMutex.h>                 // protects the prefetch state
+#include <TCondition.h>             // signals opened files
 
 using std::vector;
 using std::string;
 using std::fstream;
 
+class TThread;
 
 //===============================================================================
 //Class to read a txt file containing a list of root files
 //and load in the ntuples
+//
+//The queue owns the files: the previous file is closed when moving
+//to the next one, and the remaining ones in the destructor. A background
+//thread opens the next nPrefetch files while the current one is
+//processed (nPrefetch=0 opens the files on demand). With readAheadBytes>0
+//the thread also reads the first readAheadBytes of every prefetched local
+//file to warm up the page cache of the network file system. As before,
+//the file returned by nextFile() becomes the current directory
 //==============================================================================
 
+//timings of one file, seconds
+struct TreeQueueFileStat_t{
+  TreeQueueFileStat_t() : openTime(0), waitTime(0), readAheadTime(0), readAheadBytes(0), prefetched(false) {}
+  double openTime;      //TFile opening
+  double waitTime;      //stall of nextFile() for this file, including openTime if not prefetched
+  double readAheadTime;
+  Long64_t readAheadBytes;
+  bool prefetched;      //opened by the background thread
+};
+
 class TreeQueue{
+  friend void* treeQueuePrefetch_local(void *arg);
   public:
-  TreeQueue(){};
-  TreeQueue(string listOfRootFiles);
+  TreeQueue();
+  TreeQueue(string listOfRootFiles, unsigned int nPrefetch=1, Long64_t readAheadBytes=0);
   virtual ~TreeQueue();
   TTree* getTree(const TString& treeName);
   virtual bool nextFile(); //method to jump to next file
-  virtual void reset();
+  virtual void reset(); //start from the first file again, nextFile() gives the first file
   void printOut() const;
-  void status() const;
+  void status() const; //current file and its timings
+  void printTimings() const; //timings of all processed files
+  vector<TreeQueueFileStat_t> fileStats() const;
 
   protected:
-  TreeQueue(string listOfRootFiles,  bool isInherited);
+  TreeQueue(string listOfRootFiles,  bool isInherited, unsigned int nPrefetch, Long64_t readAheadBytes);
   vector<string> filelist;
-  vector<string>::iterator s_iter;
-  vector<string>::iterator current;
   ifstream rootFileStream;
+  void initFileSlots(); //to be called after filelist is filled
 
   private:
+  enum { _fileIdle=0, _fileOpening, _fileReady, _fileFailed, _fileClosed };
   TTree* evtTree;
-  TFile* infile;//should definitely use smart pointers here, currently have a memory leak  
+  TFile* infile;
+  int currentIdx, nextIdx;
+  unsigned int nPrefetch;
+  Long64_t readAheadBytes;
+  vector<TFile*> files;
+  vector<int> fileState;
+  vector<TreeQueueFileStat_t> fileStat;
+  mutable TMutex mutex;     //protects the members above, except infile and evtTree
+  TCondition fileOpened;
+  TThread *prefetchThread;
+  bool prefetchRunning, stopPrefetch;
+
   virtual bool storeFilenames();
-  
+  TFile* openFile(unsigned int idx, double &openTime) const;
+  void closeFile(TFile *f) const;
+  int nextToPrefetch() const; //mutex has to be locked
+  void startPrefetch();
+  void stopPrefetching();
+  void prefetchLoop();
+  void readAhead(unsigned int idx);
+  void closeAll();
+  //not copyable, owns the files
+  TreeQueue(const TreeQueue&);
+  TreeQueue& operator=(const TreeQueue&);
 };
 
 #endif
-
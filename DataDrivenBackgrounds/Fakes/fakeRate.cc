@@ -70,6 +70,7 @@ To do's
 #include "../../Include/TMuon.hh"
 
 #include "TreeQueue.hh"
+#include "LazyEvent.hh"
 
 // lumi section selection with JSON files
 // #include "RunLumiRangeMap.h"
@@ -172,7 +173,10 @@ struct check_etDiff_functor{
 
 //=== MAIN MACRO =================================================================================================
 
-void fakeRate() 
+// nPrefetch: number of the input files opened in the background while
+// the current one is processed, readAheadMB: read-ahead of every
+// prefetched file (see TreeQueue.hh)
+void fakeRate(unsigned int nPrefetch=1, int readAheadMB=0) 
 {  
   gBenchmark->Start("fakeRate");
 
@@ -205,6 +209,12 @@ void fakeRate()
 
   TClonesArray *electronArr = new TClonesArray("mithep::TElectron");
   TClonesArray *diElectronArr = new TClonesArray("mithep::TDielectron");
+
+  // The branches are read on the first access in the event, thus the
+  // cuts on Info are applied before any array is decompressed
+  LazyBranch<mithep::TEventInfo> evInfo("Info", info);
+  LazyBranch<TClonesArray> evElectrons("Electron", electronArr);
+  LazyBranch<TClonesArray> evDielectrons("Dielectron", diElectronArr);
  
   //Set up histos to store events
   const int nBins(30),xmin(0), xmax(300);
@@ -282,7 +292,15 @@ void fakeRate()
   //
   TString ts_evtfname(evtfname);
   
-  TreeQueue fakeTrees("FakeDateSource.txt");
+  TreeQueue fakeTrees("FakeDateSource.txt", nPrefetch, Long64_t(readAheadMB)*1048576);
+  LazyEvent fakeEvent;
+  fakeEvent.add(evInfo);
+  fakeEvent.add(evElectrons);
+  CutFlow fakeFlow("fake rate sample");
+  const unsigned int cutPhotonTrig = fakeFlow.declare("photon trigger");   // Info
+  const unsigned int cutNElectrons = fakeFlow.declare("nElectrons<=1");    // Electron
+  const unsigned int cutPfMET      = fakeFlow.declare("pfMET<10");         // Info
+
   //Get the Tree
   //loop over files
   cout << "start of nextfile\n";
@@ -292,8 +310,7 @@ void fakeRate()
     fakeTrees.status();
 
     // Set branch address to structures that will store the info  
-    eventTree->SetBranchAddress("Info",       &info);          TBranch *infoBr       = eventTree->GetBranch("Info");
-    eventTree->SetBranchAddress("Electron" ,  &electronArr  ); TBranch *electronBr   = eventTree->GetBranch("Electron");
+    fakeEvent.attach(eventTree);
   
     UInt_t maxEvents = eventTree->GetEntries();
      
@@ -303,19 +320,17 @@ void fakeRate()
       if(ientry >= maxEvents) break;
 	
       //info->Clear(); should add this back
-      infoBr->GetEntry(ientry);
-		
-      electronArr->Clear(); 
-      electronBr->GetEntry(ientry);
+      fakeEvent.setEntry(ientry);
+      fakeFlow.beginEvent();
 
-      //max number of electrons and photons in event
-      UInt_t maxElectronEvts = electronArr->GetEntriesFast();
-      if (maxElectronEvts > 1) continue; 
- 
       UInt_t photonTrigOr =  kHLT_Photon30_CaloIdVL | kHLT_Photon50_CaloIdVL 
       	| kHLT_Photon75_CaloIdVL | kHLT_Photon90_CaloIdVL | kHLT_Photon125 | kHLT_Photon135; 
 
-      if(!(info->triggerBits & photonTrigOr)) continue;
+      if(!fakeFlow.pass(cutPhotonTrig, evInfo->triggerBits & photonTrigOr)) continue;
+
+      //max number of electrons and photons in event
+      UInt_t maxElectronEvts = evElectrons->GetEntriesFast();
+      if (!fakeFlow.pass(cutNElectrons, maxElectronEvts <= 1)) continue; 
      
       /* 
       //reject events with 2 or more electrons
@@ -327,10 +342,10 @@ void fakeRate()
 
       if (nElec > 1) continue; */
 
-      double metVal = info->pfMET;
+      double metVal = evInfo->pfMET;
       pfMet->Fill(metVal);
       //cout << "pfMET is: " << info->pfSumET << "\n";
-      if (metVal >= 10.0) continue; //reject events with pf MET < 10
+      if (!fakeFlow.pass(cutPfMET, metVal < 10.0)) continue; //reject events with pf MET < 10
 
       // loop through photons      
       for(UInt_t i=0; i<maxElectronEvts; ++i) {
@@ -422,6 +437,9 @@ void fakeRate()
       } // end loop over photon      
     } // end loop over events
   }//end of loop over files
+  fakeTrees.printTimings();
+  fakeFlow.print();
+  fakeEvent.printStats();
 
 
   //Make a fake rate histo
@@ -501,7 +519,14 @@ void fakeRate()
   //start from first file again
   fakeTrees.reset();
 
-  TreeQueue DataTrees("DataFiles.txt");
+  TreeQueue DataTrees("DataFiles.txt", nPrefetch, Long64_t(readAheadMB)*1048576);
+  LazyEvent dataEvent;
+  dataEvent.add(evInfo);
+  dataEvent.add(evDielectrons);
+  CutFlow dataFlow("data");
+  const unsigned int cutJson    = dataFlow.declare("JSON");               // Info
+  const unsigned int cutEleTrig = dataFlow.declare("dielectron trigger"); // Info
+
 
   unsigned int jsonIndex(0);
   //loop over files
@@ -519,31 +544,27 @@ void fakeRate()
 
 
     // Set branch address to structures that will store the info  
-    eventTree->SetBranchAddress("Info",       &info);          TBranch *infoBr       = eventTree->GetBranch("Info");
-    eventTree->SetBranchAddress("Dielectron" ,  &diElectronArr  ); TBranch *diElectronBr   = eventTree->GetBranch("Dielectron");    
-    eventTree->SetBranchAddress("Electron" ,  &electronArr  ); TBranch *electronBr   = eventTree->GetBranch("Electron");
+    // (the Electron branch is not used here)
+    dataEvent.attach(eventTree);
 
     UInt_t maxEvents = eventTree->GetEntries();
 
     for(UInt_t ientry=0; ientry<maxEvents; ++ientry) {           
       if(ientry >= maxEvents) break;	
     
-      infoBr->GetEntry(ientry);		
-      diElectronArr->Clear(); 
-      diElectronBr->GetEntry(ientry); 
-      electronArr->Clear(); 
-      electronBr->GetEntry(ientry);
+      dataEvent.setEntry(ientry);
+      dataFlow.beginEvent();
 
-      if(!jsonParser.HasRunLumi(info->runNum, info->lumiSec)) continue;  // not certified run? Skip to next event...
+      if(!dataFlow.pass(cutJson, jsonParser.HasRunLumi(evInfo->runNum, evInfo->lumiSec))) continue;  // not certified run? Skip to next event...
 
       UInt_t  triggerEle = kHLT_Ele17_CaloIdL_CaloIsoVL_Ele8_CaloIdL_CaloIsoVL
             | kHLT_Ele17_CaloIdT_TrkIdVL_CaloIsoVL_TrkIsoVL_Ele8_CaloIdT_TrkIdVL_CaloIsoVL_TrkIsoVL;
 
-      if(!(info->triggerBits & triggerEle)) continue;	
+      if(!dataFlow.pass(cutEleTrig, evInfo->triggerBits & triggerEle)) continue;	
 
       vector<int> photonIndex;
 
-      UInt_t maxDiElectrons = diElectronArr->GetEntriesFast();
+      UInt_t maxDiElectrons = evDielectrons->GetEntriesFast();
 
       map<Float_t,UInt_t> elecEMap;
       map<Float_t,UInt_t> elecCandEMap;
@@ -745,6 +766,9 @@ void fakeRate()
 
     }//end of loop over events
   }//end of loop over files
+  DataTrees.printTimings();
+  dataFlow.print();
+  dataEvent.printStats();
   
   //Set current output file
   outFile->cd();
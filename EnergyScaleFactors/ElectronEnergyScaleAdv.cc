@@ -2076,6 +2076,38 @@ TEnergyScaleFactorsFitModel_t DetermineESFFitModel(const TApplication &theApp) {
 // ------------------------------------------------------------
 // ------------------------------------------------------------
 
+#ifdef EtaEtaMass_H
+// Fills the (eta1,eta2) cells from the binary store (EEMStore.hh) next to
+// the EEM file. Returns 0, if the store is not available or does not match
+// the EEM file
+int ProcessEEMStore_local(const ElectronEnergyScaleAdv_t &esf, const char *eem_file_name, std::vector<std::vector<double>*> &data) {
+  EEMStoreReader_t store;
+  if (!store.open(EEMStore_t::storeFileName(eem_file_name),eem_file_name)) return 0;
+  const int etaEtaCount=esf.EtaDivisionCount()*(esf.EtaDivisionCount()+1)/2;
+  std::vector<int> cellIdx(store.size(),-1);
+  std::vector<int> counts(etaEtaCount,0);
+  for (ULong64_t i=0; i<store.size(); ++i) {
+    int idx=esf.PrepareEtaEtaBinIdx(store.eta1()[i],store.eta2()[i]);
+    if ((idx>=0) && (idx < etaEtaCount)) { cellIdx[i]=idx; counts[idx]++; }
+  }
+  data.clear(); data.reserve(etaEtaCount+1);
+  for (int k=0; k<etaEtaCount; ++k) {
+    std::vector<double>* tmp=new std::vector<double>();
+    assert(tmp);
+    tmp->reserve(counts[k]+1);
+    data.push_back(tmp);
+  }
+  const Double_t *mass=store.mass();
+  for (ULong64_t i=0; i<store.size(); ++i) {
+    if (cellIdx[i]>=0) data[cellIdx[i]]->push_back(mass[i]);
+  }
+  std::cout << "ProcessEEMFile: " << store.size() << " records from <" << store.fileName() << ">\n";
+  return 1;
+}
+#endif
+
+// ------------------------------------------------------------
+
 #ifdef EtaEtaMass_H
 int ElectronEnergyScaleAdv_t::ProcessEEMFile(const char *mc_file_name, const char *data_file_name, std::vector<std::vector<double>*> &mcData, std::vector<std::vector<double>*> &expData) {
   EtaEtaMassData_t *eem = new EtaEtaMassData_t();
@@ -2083,6 +2115,9 @@ int ElectronEnergyScaleAdv_t::ProcessEEMFile(const char *mc_file_name, const cha
   const int etaEtaCount=this->EtaDivisionCount()*(this->EtaDivisionCount()+1)/2;
   mcData.clear(); mcData.reserve(etaEtaCount+1);
   expData.clear(); expData.reserve(etaEtaCount+1);
+  // use the binary stores, if available
+  const int mcDone=(mc_file_name && ProcessEEMStore_local(*this,mc_file_name,mcData)) ? 1:0;
+  const int expDone=(data_file_name && ProcessEEMStore_local(*this,data_file_name,expData)) ? 1:0;
   // Read each file twice. First time we will determine the number of masses
   // in each (eta1,eta2) bin and allocate memory. The second time we will
   // store the mass value
@@ -2091,7 +2126,7 @@ int ElectronEnergyScaleAdv_t::ProcessEEMFile(const char *mc_file_name, const cha
     //std::cout << "loop=" << loop << std::endl;
     std::vector<int> counts(etaEtaCount);
     const char *fname=(loop%2==0) ? mc_file_name : data_file_name;
-    if (!fname) continue;
+    if (!fname || ((loop%2==0) ? mcDone : expDone)) continue;
     std::vector<std::vector<double>*> *data= (loop%2==0) ? &mcData : &expData;
     TFile *fin = new TFile(fname);
     assert(fin);
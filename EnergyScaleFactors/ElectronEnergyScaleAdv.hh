@@ -19,6 +19,7 @@
 
 #ifdef DoSmearing
 #include <Math/ProbFuncMathCore.h>
+#include "MassSmearingTemplate.hh"
 #ifndef UseTH1D
 #define UseTH1D
 #endif
@@ -393,6 +394,17 @@ struct ElectronEnergyScaleAdv_t {
   int ScaleMCMass(double mass, int etaBin1, int etaBin2, double &scaled_mass, double *weight, HistoClass_t *h, double *appliedScaleFactor=NULL) const;
   template<class HistoClass_t>
   int SmearMass(double mass, int etaBin1, int etaBin2, int massBinCount, const double *massBins, double *result_distribution, double *weight, HistoClass_t *h, int do_smear=1) const;
+  // gauss, Breit-Wigner and voigtian smearing can use the templates
+  int TemplateSmearingSupported() const {
+    return ((this->FitModelKind()==_ESFModel_gauss) ||
+	    (this->FitModelKind()==_ESFModel_breitWigner) ||
+	    (this->FitModelKind()==_ESFModel_voigtian)) ? 1:0;
+  }
+  // scales all masses of the (etaBin1,etaBin2) MC sample by mcScaleFactor
+  // and smears them using the template. The template is built on the
+  // first call. The content and the errors are added to h
+  template<class HistoClass_t>
+  int SmearMassTemplate(const std::vector<double> &masses, int etaBin1, int etaBin2, MassSmearingTemplate_t &mcTemplate, double mcScaleFactor, int massBinCount, const double *massBins, double *result_distribution, HistoClass_t *h) const;
 
   template<class HistoClass_t>
   int ScaleMass(double mass, double eta1, double eta2, double &scaled_mass, double *weight, HistoClass_t *h, double *appliedScaleFactor=NULL) const {
@@ -432,12 +444,12 @@ struct ElectronEnergyScaleAdv_t {
 #ifdef DoSmearing
 #ifdef UsePlotsAcc
   template<class HistoClass_t>
-  int PrepareScaledSmearedData(const std::vector<mithep::AccEffData_t*> &dataMC, const std::vector<mithep::AccEffData_t*> &dataExp, int massBinCount, const double *massBins, std::vector<HistoClass_t*> &smearedMCV, std::vector<HistoClass_t*> &scaledExpV, const TString &extra, int do_smear=1, int do_scale=1);
+  int PrepareScaledSmearedData(const std::vector<mithep::AccEffData_t*> &dataMC, const std::vector<mithep::AccEffData_t*> &dataExp, int massBinCount, const double *massBins, std::vector<HistoClass_t*> &smearedMCV, std::vector<HistoClass_t*> &scaledExpV, const TString &extra, int do_smear=1, int do_scale=1, int scale_mc=0, std::vector<MassSmearingTemplate_t> *mcTemplates=NULL);
 #endif
 #endif
 
   template<class HistoClass_t, class doubleVPtr_t>
-  int PrepareScaledSmearedData(const std::vector<doubleVPtr_t> &dataMC, const std::vector<doubleVPtr_t> &dataExp, int massBinCount, const double *massBins, std::vector<HistoClass_t*> &smearedMCV, std::vector<HistoClass_t*> &scaledExpV, const TString &extra, int do_smear=1, int do_scale=1);
+  int PrepareScaledSmearedData(const std::vector<doubleVPtr_t> &dataMC, const std::vector<doubleVPtr_t> &dataExp, int massBinCount, const double *massBins, std::vector<HistoClass_t*> &smearedMCV, std::vector<HistoClass_t*> &scaledExpV, const TString &extra, int do_smear=1, int do_scale=1, int scale_mc=0, std::vector<MassSmearingTemplate_t> *mcTemplates=NULL);
   
   
   int Verify_EnoughScalingVars(const char *calling_function_name, int needs_positions, const std::vector<RooRealVar*> &vars, const std::vector<RooRealVar*> *scPars2) const;
@@ -574,6 +586,64 @@ int ElectronEnergyScaleAdv_t::SmearMass(double mass, int etaBin1, int etaBin2, i
 
 // -----------------------------------------------------------------------
 
+#ifdef DoSmearing
+template<class HistoClass_t>
+int ElectronEnergyScaleAdv_t::SmearMassTemplate(const std::vector<double> &masses, int etaBin1, int etaBin2, MassSmearingTemplate_t &mcTemplate, double mcScaleFactor, int massBinCount, const double *massBins, double *result_distribution, HistoClass_t *h) const {
+  assert(massBins); assert(result_distribution);
+  if (!mcTemplate.binCount()) {
+    // fine bins of 0.2 GeV. The margins accommodate the scaling shift
+    // and the smearing tails
+    double lo=0.8*massBins[0]-20.;
+    if (lo<0.) lo=0.;
+    const double hi=1.25*massBins[massBinCount]+20.;
+    if (!mcTemplate.build(masses,lo,hi,0.2)) return 0;
+  }
+  MassSmearingTemplate_t::TSmearing_t kind=MassSmearingTemplate_t::_smearVoigt;
+  double sigma=0, gamma=0;
+  switch(this->FitModelKind()) {
+  case _ESFModel_gauss: {
+    kind=MassSmearingTemplate_t::_smearGauss;
+    double s1=this->SmearingFactor(etaBin1);
+    double s2=this->SmearingFactor(etaBin2);
+    sigma=sqrt(s1*s1+s2*s2);
+  }
+    break;
+  case _ESFModel_breitWigner: {
+    double g1=this->Smearing(etaBin1);
+    double g2=this->Smearing(etaBin2);
+    gamma=sqrt(g1*g1+g2*g2);
+  }
+    break;
+  case _ESFModel_voigtian: {
+    double g1=this->Smearing(etaBin1);
+    double g2=this->Smearing(etaBin2);
+    double s1=this->Smearing(FEtaDivisionCount+etaBin1);
+    double s2=this->Smearing(FEtaDivisionCount+etaBin2);
+    gamma=sqrt(g1*g1+g2*g2);
+    sigma=sqrt(s1*s1+s2*s2);
+  }
+    break;
+  default:
+    std::cout << "SmearMassTemplate: model " << this->FitModelName() << " is not supported\n";
+    return 0;
+  }
+  std::vector<double> sumw2(massBinCount);
+  if (!mcTemplate.fill(mcScaleFactor,kind,sigma,gamma,massBinCount,massBins,result_distribution,&sumw2[0])) return 0;
+  if (h) {
+    for (int i=0; i<massBinCount; ++i) {
+      const double err=h->GetBinError(i+1);
+      h->SetBinContent(i+1,h->GetBinContent(i+1)+result_distribution[i]);
+      h->SetBinError(i+1,sqrt(err*err+sumw2[i]));
+    }
+    // the per-event smearing fills every mass bin once per event
+    h->SetEntries(h->GetEntries()+double(masses.size())*massBinCount);
+  }
+  return 1;
+}
+#endif
+
+// -----------------------------------------------------------------------
+
 #ifdef DoSmearing
 template<class HistoClass_t>
 int ElectronEnergyScaleAdv_t::ScaleAndSmearMass(double mass, double eta1, double eta2, int massBinCount, const double *massBins, double *result_distribution, double *weight, HistoClass_t *h, double *appliedScaleFactor) const {
@@ -608,7 +678,7 @@ int ElectronEnergyScaleAdv_t::ScaleAndSmearMCMass(double mass, double eta1, doub
 #ifdef DoSmearing
 #ifdef UsePlotsAcc
 template<class HistoClass_t>
-int ElectronEnergyScaleAdv_t::PrepareScaledSmearedData(const std::vector<mithep::AccEffData_t*> &dataMC, const std::vector<mithep::AccEffData_t*> &dataExp, int massBinCount, const double *massBins, std::vector<HistoClass_t*> &smearedMCV, std::vector<HistoClass_t*> &scaledExpV, const TString &extra, int do_smear, int do_scale) {
+int ElectronEnergyScaleAdv_t::PrepareScaledSmearedData(const std::vector<mithep::AccEffData_t*> &dataMC, const std::vector<mithep::AccEffData_t*> &dataExp, int massBinCount, const double *massBins, std::vector<HistoClass_t*> &smearedMCV, std::vector<HistoClass_t*> &scaledExpV, const TString &extra, int do_smear, int do_scale, int scale_mc, std::vector<MassSmearingTemplate_t> *mcTemplates) {
   const char *fncname="PrepareScaledSmearedData";
   const int expect_size=this->FEtaDivisionCount*(this->FEtaDivisionCount+1)/2;
   if ((expect_size!=dataMC.size()) || (expect_size!=dataExp.size())) {
@@ -640,13 +710,27 @@ int ElectronEnergyScaleAdv_t::PrepareScaledSmearedData(const std::vector<mithep:
   k=0;
   double result_distribution[massBinCount];
   double weight=1;
+  // the smearing templates are kept by the caller between the calls
+  // with the same MC samples
+  std::vector<MassSmearingTemplate_t> localTemplates;
+  if (!mcTemplates) mcTemplates=&localTemplates;
+  const int use_templates=(do_smear && this->TemplateSmearingSupported()) ? 1:0;
+  if (use_templates && (mcTemplates->size()!=(unsigned int)(expect_size))) {
+    mcTemplates->clear();
+    mcTemplates->resize(expect_size);
+  }
   for (int ib=0; ib<this->FEtaDivisionCount; ++ib) {
     for (int jb=ib; jb<this->FEtaDivisionCount; ++jb, ++k) {
       const std::vector<double>* masses=dataMC[k]->MassConstPtr();
       HistoClass_t *histo=smearedMCV[k];
+      const double mcScaleFactor=(do_scale && scale_mc) ? 1/(this->ProperScaleFactorValue(ib)*this->ProperScaleFactorValue(jb)) : 1.;
+      if (use_templates) {
+	if (!this->SmearMassTemplate(*masses,ib,jb,(*mcTemplates)[k],mcScaleFactor,massBinCount,massBins,result_distribution,histo)) return 0;
+	continue;
+      }
       for (unsigned int i=0; i<masses->size(); ++i) {
 	//std::cout << "smearing mass k=" << k << ", element=" << i << std::endl;
-	this->SmearMass((*masses)[i],ib,jb,massBinCount,massBins,result_distribution,&weight,histo, do_smear);
+	this->SmearMass(mcScaleFactor*(*masses)[i],ib,jb,massBinCount,massBins,result_distribution,&weight,histo, do_smear);
       }
     }
   }
@@ -660,7 +744,7 @@ int ElectronEnergyScaleAdv_t::PrepareScaledSmearedData(const std::vector<mithep:
       const std::vector<double>* masses=dataExp[k]->MassConstPtr();
       HistoClass_t *histo=scaledExpV[k];
       for (unsigned int i=0; i<masses->size(); ++i) {
-	this->ScaleMass((*masses)[i],ib,jb,scaled_mass,&weight,histo,NULL,do_scale);
+	this->ScaleMass((*masses)[i],ib,jb,scaled_mass,&weight,histo,NULL,(do_scale && !scale_mc) ? 1:0);
       }
     }
   }
@@ -673,7 +757,7 @@ int ElectronEnergyScaleAdv_t::PrepareScaledSmearedData(const std::vector<mithep:
 // -----------------------------------------------------------------------
 
 template<class HistoClass_t, class doubleVPtr_t>
-int ElectronEnergyScaleAdv_t::PrepareScaledSmearedData(const std::vector<doubleVPtr_t> &dataMC, const std::vector<doubleVPtr_t> &dataExp, int massBinCount, const double *massBins, std::vector<HistoClass_t*> &smearedMCV, std::vector<HistoClass_t*> &scaledExpV, const TString &extra, int do_smear, int do_scale) {
+int ElectronEnergyScaleAdv_t::PrepareScaledSmearedData(const std::vector<doubleVPtr_t> &dataMC, const std::vector<doubleVPtr_t> &dataExp, int massBinCount, const double *massBins, std::vector<HistoClass_t*> &smearedMCV, std::vector<HistoClass_t*> &scaledExpV, const TString &extra, int do_smear, int do_scale, int scale_mc, std::vector<MassSmearingTemplate_t> *mcTemplates) {
   const char *fncname="PrepareScaledSmearedData";
   const unsigned int expect_size=this->FEtaDivisionCount*(this->FEtaDivisionCount+1)/2;
   if ((expect_size!=dataMC.size()) || (expect_size!=dataExp.size())) {
@@ -705,13 +789,27 @@ int ElectronEnergyScaleAdv_t::PrepareScaledSmearedData(const std::vector<doubleV
   k=0;
   double result_distribution[massBinCount];
   double weight=1;
+  // the smearing templates are kept by the caller between the calls
+  // with the same MC samples
+  std::vector<MassSmearingTemplate_t> localTemplates;
+  if (!mcTemplates) mcTemplates=&localTemplates;
+  const int use_templates=(do_smear && this->TemplateSmearingSupported()) ? 1:0;
+  if (use_templates && (mcTemplates->size()!=(unsigned int)(expect_size))) {
+    mcTemplates->clear();
+    mcTemplates->resize(expect_size);
+  }
   for (int ib=0; ib<this->FEtaDivisionCount; ++ib) {
     for (int jb=ib; jb<this->FEtaDivisionCount; ++jb, ++k) {
       const std::vector<double>* masses=(const std::vector<double>*)(dataMC[k]);
       HistoClass_t *histo=smearedMCV[k];
+      const double mcScaleFactor=(do_scale && scale_mc) ? 1/(this->ProperScaleFactorValue(ib)*this->ProperScaleFactorValue(jb)) : 1.;
+      if (use_templates) {
+	if (!this->SmearMassTemplate(*masses,ib,jb,(*mcTemplates)[k],mcScaleFactor,massBinCount,massBins,result_distribution,histo)) return 0;
+	continue;
+      }
       for (unsigned int i=0; i<masses->size(); ++i) {
 	//std::cout << "smearing mass k=" << k << ", element=" << i << std::endl;
-	this->SmearMass((*masses)[i],ib,jb,massBinCount,massBins,result_distribution,&weight,histo, do_smear);
+	this->SmearMass(mcScaleFactor*(*masses)[i],ib,jb,massBinCount,massBins,result_distribution,&weight,histo, do_smear);
       }
     }
   }
@@ -725,7 +823,7 @@ int ElectronEnergyScaleAdv_t::PrepareScaledSmearedData(const std::vector<doubleV
       const std::vector<double>* masses=(const std::vector<double>*)(dataExp[k]);
       HistoClass_t *histo=scaledExpV[k];
       for (unsigned int i=0; i<masses->size(); ++i) {
-	this->ScaleMass((*masses)[i],ib,jb,scaled_mass,&weight,histo,NULL,do_scale);
+	this->ScaleMass((*masses)[i],ib,jb,scaled_mass,&weight,histo,NULL,(do_scale && !scale_mc) ? 1:0);
       }
     }
   }
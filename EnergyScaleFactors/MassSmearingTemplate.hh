@@ -0,0 +1,310 @@
+#ifndef MassSmearingTemplate_HH
+#define MassSmearingTemplate_HH
+
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <Math/ProbFuncMathCore.h>
+#include <TMath.h>
+
+// Scaled and smeared mass shape of an (eta,eta) MC sample
+//
+// The masses are histogrammed once on a fine uniform grid. A scale
+// factor is applied by resampling the fine histogram (the content of
+// a fine bin is spread uniformly over the scaled bin), the smearing is
+// a convolution with the bin-integrated kernel (gauss or voigtian)
+// evaluated by FFT. The spectrum of the resampled histogram and the
+// spectrum of the kernel are cached and reused while the scale factor
+// or the kernel parameters do not change. The cost of an evaluation
+// depends on the fine bin count only, not on the number of masses.
+//
+// The masses outside of the fine range are dropped, thus the range
+// should extend beyond the mass binning of the result by several
+// smearing widths (and by the expected scaling shift)
+//
+// The sum of squared weights of a mass bin is sum_j n_j*P_j^2, where
+// n_j is the (scaled) content of the fine bin j and P_j is the
+// probability of a mass from the fine bin j to end up in the mass bin.
+// It is the same as the per-event smearing gives for unit weights
+
+// --------------------------------------------------------------
+
+class MassSmearingTemplate_t {
+public:
+  typedef enum { _smearNone=0, _smearGauss, _smearVoigt } TSmearing_t;
+
+protected:
+  double FLo, FBinWidth;
+  int FN, FNFFT;
+  std::vector<double> FCounts;
+  double FEntries;
+  // cache of the resampled histogram and of its spectrum
+  int FScaledValid, FSpectrumValid;
+  double FScaleFactor;
+  std::vector<double> FScaled, FScaledRe, FScaledIm;
+  // cache of the kernel, of its cumulative sum and of its spectrum.
+  // FKernel[FN-1+k] is the weight of the offset k
+  int FKernelValid, FKernelSpectrumValid;
+  TSmearing_t FKernelKind;
+  double FSigma, FGamma;
+  std::vector<double> FKernel, FKernelCum;
+  std::vector<double> FKernelRe, FKernelIm;
+  // cache of the result on the fine grid
+  int FResultValid;
+  std::vector<double> FResult;
+
+public:
+  MassSmearingTemplate_t() :
+    FLo(0.), FBinWidth(0.), FN(0), FNFFT(0), FCounts(), FEntries(0.),
+    FScaledValid(0), FSpectrumValid(0), FScaleFactor(0.),
+    FScaled(), FScaledRe(), FScaledIm(),
+    FKernelValid(0), FKernelSpectrumValid(0),
+    FKernelKind(_smearNone), FSigma(0.), FGamma(0.),
+    FKernel(), FKernelCum(), FKernelRe(), FKernelIm(),
+    FResultValid(0), FResult()
+  {}
+
+  int binCount() const { return FN; }
+  double lo() const { return FLo; }
+  double hi() const { return FLo + FN*FBinWidth; }
+  double binWidth() const { return FBinWidth; }
+  double entries() const { return FEntries; }
+  const std::vector<double>& counts() const { return FCounts; }
+
+  // histograms the masses on the fine grid [lo,hi) with the given bin width
+  int build(const double *masses, unsigned int n, double lo, double hi, double binWidth, const double *weights=NULL) {
+    if ((hi<=lo) || (binWidth<=0.)) {
+      std::cout << "MassSmearingTemplate_t::build: bad range (" << lo << "," << hi << "), binWidth=" << binWidth << "\n";
+      return 0;
+    }
+    FLo=lo;
+    FBinWidth=binWidth;
+    FN=int(ceil((hi-lo)/binWidth - 1e-9));
+    FNFFT=1;
+    while (FNFFT<2*FN) FNFFT*=2;
+    FCounts.assign(FN,0.);
+    FEntries=0.;
+    for (unsigned int i=0; i<n; ++i) {
+      const double w=(weights) ? weights[i] : 1.;
+      FEntries+=w;
+      const double x=(masses[i]-FLo)/FBinWidth;
+      if ((x<0.) || (x>=FN)) continue;
+      FCounts[int(x)]+=w;
+    }
+    FScaledValid=0;
+    FSpectrumValid=0;
+    FKernelValid=0;
+    FKernelSpectrumValid=0;
+    FResultValid=0;
+    return 1;
+  }
+
+  int build(const std::vector<double> &masses, double lo, double hi, double binWidth) {
+    return this->build((masses.size()) ? &masses[0] : NULL, masses.size(), lo, hi, binWidth);
+  }
+
+  // the scaled and smeared distribution on the fine grid. For voigtian,
+  // gamma is the full width of the Breit-Wigner
+  const std::vector<double>& fineDistribution(double scaleFactor, TSmearing_t kind, double sigma, double gamma=0.) {
+    this->prepare(scaleFactor,kind,sigma,gamma);
+    if (FKernelKind==_smearNone) return FScaled;
+    if (!FSpectrumValid) {
+      FScaledRe.assign(FNFFT,0.);
+      FScaledIm.assign(FNFFT,0.);
+      std::copy(FScaled.begin(),FScaled.end(),FScaledRe.begin());
+      fft(FScaledRe,FScaledIm,0);
+      FSpectrumValid=1;
+      FResultValid=0;
+    }
+    if (!FKernelSpectrumValid) {
+      FKernelRe.assign(FNFFT,0.);
+      FKernelIm.assign(FNFFT,0.);
+      // negative offsets are wrapped to the end of the FFT array
+      for (int k=-(FN-1); k<FN; ++k) {
+	FKernelRe[(k>=0) ? k : FNFFT+k]=FKernel[FN-1+k];
+      }
+      fft(FKernelRe,FKernelIm,0);
+      FKernelSpectrumValid=1;
+      FResultValid=0;
+    }
+    if (FResultValid) return FResult;
+    std::vector<double> re(FNFFT), im(FNFFT);
+    for (int i=0; i<FNFFT; ++i) {
+      re[i]=FScaledRe[i]*FKernelRe[i] - FScaledIm[i]*FKernelIm[i];
+      im[i]=FScaledRe[i]*FKernelIm[i] + FScaledIm[i]*FKernelRe[i];
+    }
+    fft(re,im,1);
+    FResult.resize(FN);
+    for (int i=0; i<FN; ++i) FResult[i]=(re[i]>0.) ? re[i] : 0.;
+    FResultValid=1;
+    return FResult;
+  }
+
+  // the scaled and smeared distribution integrated over the mass bins.
+  // If sumw2 is given, the sums of squared weights are stored there
+  int fill(double scaleFactor, TSmearing_t kind, double sigma, double gamma, int massBinCount, const double *massBins, double *result_distribution, double *sumw2=NULL) {
+    if (!FN) {
+      std::cout << "MassSmearingTemplate_t::fill: template was not built\n";
+      return 0;
+    }
+    const std::vector<double> &fine=this->fineDistribution(scaleFactor,kind,sigma,gamma);
+    for (int i=0; i<massBinCount; ++i) result_distribution[i]=0.;
+    for (int j=0; j<FN; ++j) {
+      if (fine[j]==0.) continue;
+      const double a=FLo + j*FBinWidth;
+      addOverlap(a,a+FBinWidth,fine[j],massBinCount,massBins,result_distribution);
+    }
+    if (sumw2) {
+      // positions of the mass bin edges on the fine grid
+      std::vector<double> t(massBinCount+1);
+      for (int i=0; i<=massBinCount; ++i) t[i]=(massBins[i]-FLo)/FBinWidth;
+      for (int i=0; i<massBinCount; ++i) sumw2[i]=0.;
+      for (int j=0; j<FN; ++j) {
+	const double c=FScaled[j];
+	if (c==0.) continue;
+	double cdfLo=this->kernelCdf(t[0]-j);
+	for (int i=0; i<massBinCount; ++i) {
+	  const double cdfHi=this->kernelCdf(t[i+1]-j);
+	  const double p=cdfHi-cdfLo;
+	  sumw2[i]+=c*p*p;
+	  cdfLo=cdfHi;
+	}
+      }
+    }
+    return 1;
+  }
+
+protected:
+  // updates the resampled histogram and the kernel, invalidating the
+  // dependent caches on a change
+  void prepare(double scaleFactor, TSmearing_t kind, double sigma, double gamma) {
+    if ((kind==_smearGauss) && (sigma<=0.)) kind=_smearNone;
+    if ((kind==_smearVoigt) && (sigma<=0.) && (gamma<=0.)) kind=_smearNone;
+    if (kind==_smearNone) { sigma=0.; gamma=0.; }
+    if (kind==_smearGauss) gamma=0.;
+    if (!FScaledValid || (scaleFactor!=FScaleFactor)) {
+      resample(scaleFactor,FScaled);
+      FScaleFactor=scaleFactor;
+      FScaledValid=1;
+      FSpectrumValid=0;
+      FResultValid=0;
+    }
+    if (!FKernelValid || (kind!=FKernelKind) || (sigma!=FSigma) || (gamma!=FGamma)) {
+      tabulateKernel(kind,sigma,gamma);
+      FKernelKind=kind;
+      FSigma=sigma;
+      FGamma=gamma;
+      FKernelValid=1;
+      FKernelSpectrumValid=0;
+      FResultValid=0;
+    }
+  }
+
+  // the weight of the kernel below the offset x (in fine bins) from the
+  // lower edge of the source bin. The offset k collects the fine bin
+  // [k,k+1), its weight is spread uniformly over the bin
+  double kernelCdf(double x) const {
+    const int m=int(floor(x));
+    if (m<-(FN-1)) return 0.;
+    if (m>=FN) return FKernelCum[2*FN-1];
+    const int idx=m+FN-1;
+    return FKernelCum[idx] + (x-m)*FKernel[idx];
+  }
+
+  // spreads the content of [a,b) over the bins proportionally to the overlap
+  static void addOverlap(double a, double b, double content, int binCount, const double *bins, double *result) {
+    if ((b<=bins[0]) || (a>=bins[binCount])) return;
+    int j=int(std::upper_bound(bins,bins+binCount+1,a)-bins) - 1;
+    if (j<0) j=0;
+    const double norm=content/(b-a);
+    for ( ; (j<binCount) && (bins[j]<b); ++j) {
+      const double overlap=std::min(b,bins[j+1]) - std::max(a,bins[j]);
+      if (overlap>0.) result[j]+=norm*overlap;
+    }
+  }
+
+  // fine bin i covers [scale*x_i, scale*x_{i+1}) after scaling
+  void resample(double scaleFactor, std::vector<double> &scaled) const {
+    if (scaleFactor==1.) { scaled=FCounts; return; }
+    scaled.assign(FN,0.);
+    const double hiEdge=FLo + FN*FBinWidth;
+    for (int i=0; i<FN; ++i) {
+      const double c=FCounts[i];
+      if (c==0.) continue;
+      const double a=scaleFactor*(FLo + i*FBinWidth);
+      const double b=scaleFactor*(FLo + (i+1)*FBinWidth);
+      if ((b<=FLo) || (a>=hiEdge)) continue;
+      int j=int(floor((a-FLo)/FBinWidth));
+      if (j<0) j=0;
+      const double norm=c/(b-a);
+      for ( ; j<FN; ++j) {
+	const double lo=FLo + j*FBinWidth;
+	if (lo>=b) break;
+	const double overlap=std::min(b,lo+FBinWidth) - std::max(a,lo);
+	if (overlap>0.) scaled[j]+=norm*overlap;
+      }
+    }
+  }
+
+  // kernel integrated over the fine bins centered at offsets k*binWidth
+  void tabulateKernel(TSmearing_t kind, double sigma, double gamma) {
+    FKernel.assign(2*FN-1,0.);
+    const double h=0.5*FBinWidth;
+    for (int k=-(FN-1); k<FN; ++k) {
+      const double x=k*FBinWidth;
+      double w=0.;
+      if (kind==_smearNone) {
+	w=(k==0) ? 1. : 0.;
+      }
+      else if (kind==_smearGauss) {
+	w=ROOT::Math::gaussian_cdf(x+h,sigma) - ROOT::Math::gaussian_cdf(x-h,sigma);
+      }
+      else {
+	// Simpson's rule within the fine bin
+	w=FBinWidth/6.*(TMath::Voigt(x-h,sigma,gamma) +
+			4*TMath::Voigt(x,sigma,gamma) +
+			TMath::Voigt(x+h,sigma,gamma));
+      }
+      FKernel[FN-1+k]=w;
+    }
+    // FKernelCum[i] is the sum of FKernel[0..i)
+    FKernelCum.assign(2*FN,0.);
+    for (int i=0; i<2*FN-1; ++i) FKernelCum[i+1]=FKernelCum[i]+FKernel[i];
+  }
+
+  // in-place radix-2 complex FFT. The array size has to be a power of 2
+  static void fft(std::vector<double> &re, std::vector<double> &im, int inverse) {
+    const int n=int(re.size());
+    for (int i=1, j=0; i<n; ++i) {
+      int bit=n>>1;
+      for ( ; j & bit; bit>>=1) j^=bit;
+      j^=bit;
+      if (i<j) { std::swap(re[i],re[j]); std::swap(im[i],im[j]); }
+    }
+    for (int len=2; len<=n; len<<=1) {
+      const double ang=2*M_PI/len * ((inverse) ? 1 : -1);
+      const double wRe=cos(ang), wIm=sin(ang);
+      for (int i=0; i<n; i+=len) {
+	double uRe=1., uIm=0.;
+	for (int j=0; j<len/2; ++j) {
+	  const int p=i+j, q=i+j+len/2;
+	  const double tRe=re[q]*uRe - im[q]*uIm;
+	  const double tIm=re[q]*uIm + im[q]*uRe;
+	  re[q]=re[p]-tRe; im[q]=im[p]-tIm;
+	  re[p]+=tRe; im[p]+=tIm;
+	  const double nRe=uRe*wRe - uIm*wIm;
+	  uIm=uRe*wIm + uIm*wRe;
+	  uRe=nRe;
+	}
+      }
+    }
+    if (inverse) {
+      for (int i=0; i<n; ++i) { re[i]/=n; im[i]/=n; }
+    }
+  }
+};
+
+// --------------------------------------------------------------
+
+#endif
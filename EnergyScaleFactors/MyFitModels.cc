@@ -24,6 +24,8 @@
 #include "TLatex.h"
 
 #include "TFile.h"
+#include "TStopwatch.h"
+#include "TMinuit.h"
 #include "HelpingTools.hh"
 
 
@@ -595,6 +597,58 @@ RooSimultaneous* CreateCombinedModel(TString name, TString descr, std::vector<Ro
   return simPdf;
 }
 
+// --------------------------------------------------------------------
+
+int fitNumCPU=0;
+int fitBenchmark=0;
+
+int FitNumCPU() {
+  // the escale jobs run in parallel (evaluateEScaleSyst.sh), so the
+  // default stays at the 2 processes of the former fitTo calls
+  return (fitNumCPU>0) ? fitNumCPU : 2;
+}
+
+// --------------------------------------------------------------------
+
+RooFitResult* FitSimultaneous(std::ostream &out, RooSimultaneous &simPdf, RooDataSet &combData, int categoryCount, const RooArgSet *minosParams) {
+  const int nCPU=FitNumCPU();
+  out << "FitSimultaneous: " << categoryCount << " categories, " << combData.numEntries() << " entries, " << nCPU << " process(es) for the likelihood" << std::endl;
+  if (!fitBenchmark) {
+    if (minosParams) {
+      return simPdf.fitTo(combData,RooFit::Extended(true),RooFit::NumCPU(nCPU,true), RooFit::Timer(true),RooFit::Save(),RooFit::Minos(*minosParams));
+    }
+    return simPdf.fitTo(combData,RooFit::Extended(true),RooFit::NumCPU(nCPU,true), RooFit::Timer(true),RooFit::Save());
+  }
+
+  // benchmark: the steps of fitTo, timed separately
+  TStopwatch watch;
+  RooAbsReal *nll=simPdf.createNLL(combData,RooFit::Extended(true),RooFit::NumCPU(nCPU,true));
+  watch.Stop();
+  const double tNLL=watch.RealTime();
+  RooMinuit m(*nll);
+  watch.Start(kTRUE);
+  const int migradStatus=m.migrad();
+  watch.Stop();
+  const double tMigrad=watch.RealTime(), tMigradCPU=watch.CpuTime();
+  const int nCalls=(gMinuit) ? gMinuit->fNfcn : 0;
+  watch.Start(kTRUE);
+  m.hesse();
+  if (minosParams) m.minos(*minosParams);
+  watch.Stop();
+  const double tErrors=watch.RealTime();
+  RooFitResult *res=m.save();
+  delete nll;
+
+  out << "FitSimultaneous benchmark (" << nCPU << " process(es)):\n";
+  out << "  likelihood set up   " << tNLL << " s\n";
+  out << "  migrad (status=" << migradStatus << ") " << tMigrad << " s real, " << tMigradCPU << " s cpu in the main process\n";
+  out << "  NLL evaluations (Minuit FCN calls) " << nCalls;
+  if (nCalls>0) out << ", " << (1e3*tMigrad/nCalls) << " ms per NLL evaluation (not per Migrad iteration)";
+  out << "\n";
+  out << "  hesse" << ((minosParams) ? "+minos " : " ") << tErrors << " s" << std::endl;
+  return res;
+}
+
 // ======================================================================
 // ======================================================================
 
@@ -1869,7 +1923,7 @@ int FitBreitWignerIlyaSpecial(const std::vector<RooDataSet*> &ds, RooRealVar &x,
   //RooPlot *frame2 = NULL;
   TString frame2Name;
 
-  if (!fit_dont_fit) simPdf->fitTo(*combData, RooFit::Extended(true), RooFit::NumCPU(2,true), RooFit::Timer(true));
+  if (!fit_dont_fit) delete FitSimultaneous(std::cout,*simPdf,*combData,2);
   frame2Name = "implicit fit";
 
   if (info.NameOk()) {
@@ -2314,12 +2368,12 @@ int FitPFStemMCGauss(const std::vector<RooDataSet*> &ds, RooRealVar &x, RooRealV
     //TVirtualFitter::SetMaxIterations(MIGRAD_max_iters);
     for (unsigned int iter=0; iter<1; ++iter) { // no improvement due to more iters
       if (1) {
-	fitRes=simPdf->fitTo(*combData,RooFit::Extended(true),RooFit::NumCPU(2,true), RooFit::Timer(true),RooFit::Save(),RooFit::Minos(calcAsymmErr));
+	fitRes=FitSimultaneous(std::cout,*simPdf,*combData,N,&calcAsymmErr);
       }
       else {
 	std::cout << "\n ** Warning ** skewed error\n";
-	fitRes=simPdf->fitTo(*combData,RooFit::Extended(true),RooFit::NumCPU(2,true), RooFit::Timer(true),RooFit::Save());
-	fitRes=simPdf->fitTo(*combData,RooFit::Extended(true),RooFit::NumCPU(2,true), RooFit::Timer(true),RooFit::Save(),RooFit::Minos(calcAsymmErr));
+	fitRes=FitSimultaneous(std::cout,*simPdf,*combData,N);
+	fitRes=FitSimultaneous(std::cout,*simPdf,*combData,N,&calcAsymmErr);
       }
     }
   }
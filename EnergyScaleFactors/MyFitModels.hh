@@ -285,6 +285,16 @@ int SetInitialPassFailEffValues(unsigned int count, const std::vector<RooDataSet
 RooDataSet* CreateCombinedData(TString name,TString descr, const std::vector<RooDataSet*> &data, RooRealVar &x, RooCategory &sample, const std::vector<TString> &categories);
 RooSimultaneous* CreateCombinedModel(TString name, TString descr, std::vector<RooAddPdf*> &model, RooCategory &sample, const std::vector<TString> &categories);
 
+// Fit of a simultaneous pdf. The likelihood is evaluated by fitNumCPU
+// processes (RooFit::NumCPU, the events are interleaved). fitNumCPU=0
+// gives the default of 2 processes.
+// With fitBenchmark=1 the likelihood is minimized by RooMinuit directly,
+// and the time of Migrad and per NLL evaluation (FCN call) is printed
+extern int fitNumCPU;
+extern int fitBenchmark;
+int FitNumCPU();
+RooFitResult* FitSimultaneous(std::ostream &out, RooSimultaneous &simPdf, RooDataSet &combData, int categoryCount, const RooArgSet *minosParams=NULL);
+
 // --------------------------------------------------------------------
 // --------------------------------------------------------------------
 
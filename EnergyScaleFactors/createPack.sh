@@ -1,7 +1,7 @@
 date="`date +%Y%m%d`"
 dir="dir-Pack${date}/"
 
-files="ElectronEnergyScaleAdv.cc ElectronEnergyScaleAdv.hh ElectronEnergyScaleAdv.C"
+files="ElectronEnergyScaleAdv.cc ElectronEnergyScaleAdv.hh ElectronEnergyScaleAdv.C MassSmearingTemplate.hh"
 files="${files} HelpingTools.hh HelpingTools.cc HelpingTools.C"
 files="${files} MyFitModels.hh MyFitModels.cc"
 files="${files} example_run*.C"
@@ -678,10 +678,11 @@ int FitMassSmearingIIe(std::ostream &out, unsigned int bin_count, const std::vec
  
   RooFitResult *fitRes=NULL;
   if (!fit_dont_fit) {
-    fitRes=simPdf->fitTo(*combData,RooFit::Extended(true),RooFit::NumCPU(2,true), RooFit::Timer(true),RooFit::Save()); //,RooFit::Range("myFitRange"));
+    fitRes=FitSimultaneous(out,*simPdf,*combData,k); //,RooFit::Range("myFitRange"));
     if (fit_extra_flag==1) {
       out << " ** fit_extra_flag=1. Calling the fit again, to get asymm.errors\n";
-      fitRes=simPdf->fitTo(*combData,RooFit::Extended(true),RooFit::NumCPU(2,true), RooFit::Timer(true),RooFit::Save(),RooFit::Minos(calcAsymmErr)); //,RooFit::Range("myFitRange"));
+      const RooArgSet minosSet(calcAsymmErr);
+      fitRes=FitSimultaneous(out,*simPdf,*combData,k,&minosSet); //,RooFit::Range("myFitRange"));
     }
   }
 
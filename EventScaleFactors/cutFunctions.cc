@@ -114,6 +114,37 @@ bool isTag(const mithep::TElectron *electron, ULong_t trigger, double rho){
 
 // -------------------------------------------------------------------
 
+void evaluateLegIDs(const TClonesArray *dielectronArr, double rho, EleIDBatch_t &batch, std::vector<UInt_t> &idBits, std::vector<UInt_t> *tagIDBits){
+
+  batch.clear();
+  for(Int_t i=0; i<dielectronArr->GetEntriesFast(); i++) {
+    batch.addLegs((const mithep::TDielectron*)(dielectronArr->At(i)), rho);
+  }
+  if(DYTools::energy8TeV == 1){
+    EGMIDKernel_t<EGM2012,WP_MEDIUM>::evaluate(batch, idBits);
+    if (tagIDBits) EGMIDKernel_t<EGM2012,WP_TIGHT>::evaluate(batch, *tagIDBits);
+  }else{
+    EGMIDKernel_t<EGM2011,WP_MEDIUM>::evaluate(batch, idBits);
+    if (tagIDBits) EGMIDKernel_t<EGM2011,WP_TIGHT>::evaluate(batch, *tagIDBits);
+  }
+}
+
+// -------------------------------------------------------------------
+
+bool isTag(const mithep::TDielectron *dielectron, int leg, bool legPassesIDTag, ULong_t trigger){
+
+  const ULong_t hltMatchBits = (leg==1) ? dielectron->hltMatchBits_1 : dielectron->hltMatchBits_2;
+  const Float_t scEta = (leg==1) ? dielectron->scEta_1 : dielectron->scEta_2;
+  const Float_t pt = (leg==1) ? dielectron->pt_1 : dielectron->pt_2;
+  bool elePassHLT = (hltMatchBits & trigger);
+  bool notInGap = ! DYTools::isEcalGap( scEta );
+  bool result = ( legPassesIDTag && elePassHLT && notInGap && (pt > 25) );
+
+  return result;
+}
+
+// -------------------------------------------------------------------
+
 TString getLabel(int sample, DYTools::TEfficiencyKind_t effType, int method,  DYTools::TEtBinSet_t etBinning, DYTools::TEtaBinSet_t etaBinning, const TriggerSelection &trigSet){
   using namespace DYTools;
 
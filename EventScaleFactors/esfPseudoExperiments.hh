@@ -0,0 +1,358 @@
+#ifndef esfPseudoExperiments_HH
+#define esfPseudoExperiments_HH
+
+#include <TMatrixD.h>
+#include <TRandom.h>
+#include <TString.h>
+#include <TThread.h>
+#include <vector>
+#include <iostream>
+#include <math.h>
+
+#include "../Include/DYTools.hh"
+
+// --------------------------------------------------------
+//
+// Central single-electron scale factors data/MC in a contiguous table
+// indexed by (kind, et*nEtaBins+eta). The index nEtBins*nEtaBins is
+// the slot of the electrons outside of the binning, where the scale
+// factor is 1. The events keep the indices of their electrons
+// (esfSelectEvent_t::setEsfIndices), thus the event scale factor is
+// a product of two table entries without any bin search.
+//
+// --------------------------------------------------------
+
+class EsfTable_t {
+public:
+  enum { _nEffKinds=3 };
+protected:
+  int fEtBinCount, fEtaBinCount;
+  std::vector<double> fSF;          // [kind][etEta]
+  std::vector<double> fElectronSF;  // [etEta], product over the kinds
+public:
+  EsfTable_t() : fEtBinCount(0), fEtaBinCount(0), fSF(), fElectronSF() {}
+
+  int prepare(DYTools::TEtBinSet_t etBinning, DYTools::TEtaBinSet_t etaBinning,
+	      const std::vector<TMatrixD*> &dataEff, 
+	      const std::vector<TMatrixD*> &mcEff) {
+    fEtBinCount=DYTools::getNEtBins(etBinning);
+    fEtaBinCount=DYTools::getNEtaBins(etaBinning);
+    const int n=binCount();
+    if ((dataEff.size()<_nEffKinds) || (mcEff.size()<_nEffKinds)) {
+      std::cout << "EsfTable::prepare: efficiencies are not loaded\n";
+      return 0;
+    }
+    fSF.assign(_nEffKinds*(n+1), 1.);
+    fElectronSF.assign(n+1, 1.);
+    for (int kind=0; kind<_nEffKinds; ++kind) {
+      for (int iEt=0; iEt<fEtBinCount; ++iEt) {
+	for (int iEta=0; iEta<fEtaBinCount; ++iEta) {
+	  fSF[kind*(n+1) + iEt*fEtaBinCount+iEta] = 
+	    (*dataEff[kind])[iEt][iEta] / (*mcEff[kind])[iEt][iEta];
+	}
+      }
+    }
+    for (int i=0; i<n; ++i) {
+      fElectronSF[i]= sf(0,i) * sf(1,i) * sf(2,i);
+    }
+    return 1;
+  }
+
+  // number of (et,eta) bins = index of the out-of-range slot
+  int binCount() const { return fEtBinCount*fEtaBinCount; }
+
+  double sf(int kind, int idx) const { return fSF[kind*(binCount()+1) + idx]; }
+  double electronSF(int idx) const { return fElectronSF[idx]; }
+  double eventSF(int idx1, int idx2) const { 
+    return fElectronSF[idx1]*fElectronSF[idx2];
+  }
+  double eventSF(int kind, int idx1, int idx2) const { 
+    return sf(kind,idx1)*sf(kind,idx2);
+  }
+};
+
+// --------------------------------------------------------
+//
+// Pseudo-experiments for the errors of the event scale factors.
+//
+// For every pseudo-experiment the data and MC efficiencies are
+// smeared within their errors, and the smeared single-electron
+// scale factors are stored in one contiguous table indexed by
+// (kind, et*nEtaBins+eta, exp). As in EsfTable_t, the last (et,eta)
+// slot holds the factor 1 for the electrons outside of the binning.
+// The pseudo-experiment index runs fastest,
+// thus for a given event all toy scale factors are computed by
+// unit-stride loops over the pseudo-experiments, which the compiler
+// can vectorize.
+//
+// Only the mean of the scale factor distribution of a pseudo-experiment
+// enters the error estimate. The sums of the weights and of the
+// weighted scale factors are kept instead of histograms. As for
+// TH1F("",150,0.,1.5)::GetMean, the values outside [0,1.5) are
+// not counted.
+//
+// The events are collected in memory by addEvent. run() splits the
+// pseudo-experiments between threads, every thread goes over all events
+// for its pseudo-experiments. The result does not depend on the
+// number of threads.
+//
+// --------------------------------------------------------
+
+struct EsfToyEvent_t {
+  int sfIdx1, sfIdx2;   // (et,eta) index of the electrons, see EsfTable_t
+  int massBin, flatIdx; // flatIdx=-1 if not in the unfolding bins
+  double weight;
+  int zPeak;            // 60<mass<120
+};
+
+// --------------------------------------------------------
+
+class EsfPseudoExperiments_t {
+public:
+  enum { _kindReco=0, _kindId, _kindHlt, _kindEvent, _kindCount };
+  enum { _nEffKinds=3 };
+protected:
+  int fNExps;
+  int fEtBinCount, fEtaBinCount, fNMassBins, fNFlatBins;
+  double fLowLimit, fHighLimit;
+  std::vector<double> fSF;            // [kind][et][eta][exp]
+  std::vector<EsfToyEvent_t> fEvents;
+  std::vector<double> fSumW, fSumWX;  // [massBin][kind][exp]
+  std::vector<double> fSumWFI, fSumWXFI; // [flatIdx][kind][exp]
+  std::vector<double> fEsfEvtWFI;     // [flatIdx][exp], sum of weight*esf
+  std::vector<double> fEsfEvtWZpeak;  // [exp], the same for the Z peak
+
+public:
+  EsfPseudoExperiments_t(int nExps, int nMassBins, int nFlatBins,
+			 double lowLimit=0., double highLimit=1.5) :
+    fNExps(nExps), fEtBinCount(0), fEtaBinCount(0),
+    fNMassBins(nMassBins), fNFlatBins(nFlatBins),
+    fLowLimit(lowLimit), fHighLimit(highLimit),
+    fSF(), fEvents(),
+    fSumW(nMassBins*_kindCount*nExps,0.), fSumWX(nMassBins*_kindCount*nExps,0.),
+    fSumWFI(nFlatBins*_kindCount*nExps,0.), fSumWXFI(nFlatBins*_kindCount*nExps,0.),
+    fEsfEvtWFI(nFlatBins*nExps,0.), fEsfEvtWZpeak(nExps,0.)
+  {}
+
+  int expCount() const { return fNExps; }
+  unsigned int eventCount() const { return fEvents.size(); }
+
+  // --------------------
+  // Smear the efficiencies and tabulate the scale factors.
+  // The random numbers are drawn from gRandom in the same order
+  // as in the original calcEventEff code: for each pseudo-experiment,
+  // all (kind,et,eta) offsets for data, then all for MC
+
+  int prepare(DYTools::TEtBinSet_t etBinning, DYTools::TEtaBinSet_t etaBinning,
+	      const std::vector<TMatrixD*> &dataEff, const std::vector<TMatrixD*> &dataEffAvgErr,
+	      const std::vector<TMatrixD*> &mcEff, const std::vector<TMatrixD*> &mcEffAvgErr,
+	      int debug_pseudo_exps=0) {
+    fEtBinCount=DYTools::getNEtBins(etBinning);
+    fEtaBinCount=DYTools::getNEtaBins(etaBinning);
+    if ((fEtBinCount>DYTools::nEtBinsMax) || (fEtaBinCount>DYTools::nEtaBinsMax)) {
+      std::cout << "EsfPseudoExperiments::prepare: too many bins\n";
+      return 0;
+    }
+    const int nKindBins=DYTools::nEtBinsMax*DYTools::nEtaBinsMax;
+    std::vector<double> roData(_nEffKinds*nKindBins), roMC(_nEffKinds*nKindBins);
+    fSF.assign(_nEffKinds*(fEtBinCount*fEtaBinCount+1)*fNExps, 1.);
+
+    for (int iexp=0; iexp<fNExps; ++iexp) {
+      for (int isMC=0; isMC<2; ++isMC) {
+	std::vector<double> &ro= (isMC) ? roMC : roData;
+	const double sign= (isMC) ? -1 : 1;
+	for (int kind=0; kind<_nEffKinds; ++kind) {
+	  for (int iEt=0; iEt<DYTools::nEtBinsMax; ++iEt) {
+	    for (int iEta=0; iEta<DYTools::nEtaBinsMax; ++iEta) {
+	      const int i=kind*nKindBins + iEt*DYTools::nEtaBinsMax + iEta;
+	      // In the special case of the RECO efficiency for low Et
+	      // electrons, some eta bins are MERGED in tag and probe.
+	      // However the binning is kept standard, so the values
+	      // for the efficiencies in the merged bins are the same,
+	      // and the errors are 100% correlated. Take this into
+	      // account and make the smearing 100% correlated as well.
+	      if( kind == 0 && etaBinning == DYTools::ETABINS5
+		  && (DYTools::getEtBinLimits(etBinning))[iEt+1] <= 20.0
+		  && (iEta == 1 || iEta == 4)    ) {
+		// For iEta == 1 or 4, fall back to the values for iEta == 0 or 3.
+		ro[i]= ro[i-1];
+	      }
+	      else {
+		// The default case, all other efficiencies and bins
+		ro[i]= (debug_pseudo_exps) ?
+		  sign*((kind+1)*100 + (iEt+1)*10 + iEta+1) :
+		  gRandom->Gaus(0.0,1.0);
+	      }
+	    }
+	  }
+	}
+      }
+
+      for (int kind=0; kind<_nEffKinds; ++kind) {
+	for (int iEt=0; iEt<fEtBinCount; ++iEt) {
+	  for (int iEta=0; iEta<fEtaBinCount; ++iEta) {
+	    const int i=kind*nKindBins + iEt*DYTools::nEtaBinsMax + iEta;
+	    double effData=
+	      (*dataEff[kind])[iEt][iEta] + roData[i] * (*dataEffAvgErr[kind])[iEt][iEta];
+	    double effMC=
+	      (*mcEff[kind])[iEt][iEta] + roMC[i] * (*mcEffAvgErr[kind])[iEt][iEta];
+	    fSF[sfIndex(kind,iEt*fEtaBinCount+iEta) + iexp] = effData/effMC;
+	  }
+	}
+      }
+    }
+    return 1;
+  }
+
+  // --------------------
+
+  // Add an event. (et,eta) bins equal to -1 mean that the electron
+  // is outside the calibrated range (scale factor 1)
+  void addEvent(int etBin1, int etaBin1, int etBin2, int etaBin2,
+		int massBin, int flatIdx, double weight, int zPeak) {
+    const int outIdx=fEtBinCount*fEtaBinCount;
+    addEventIdx(((etBin1!=-1) && (etaBin1!=-1)) ? etBin1*fEtaBinCount+etaBin1 : outIdx,
+		((etBin2!=-1) && (etaBin2!=-1)) ? etBin2*fEtaBinCount+etaBin2 : outIdx,
+		massBin,flatIdx,weight,zPeak);
+  }
+
+  // The same with the (et,eta) indices of EsfTable_t
+  void addEventIdx(int sfIdx1, int sfIdx2,
+		   int massBin, int flatIdx, double weight, int zPeak) {
+    if ((massBin<0) || (massBin>=fNMassBins)) return;
+    EsfToyEvent_t ev;
+    ev.sfIdx1=sfIdx1;
+    ev.sfIdx2=sfIdx2;
+    ev.massBin=massBin;
+    ev.flatIdx= ((flatIdx>=0) && (flatIdx<fNFlatBins)) ? flatIdx : -1;
+    ev.weight=weight;
+    ev.zPeak=zPeak;
+    fEvents.push_back(ev);
+  }
+
+  // --------------------
+
+  // Process the events for the pseudo-experiments [firstExp,lastExp)
+  void process(int firstExp, int lastExp) {
+    const int n=lastExp-firstExp;
+    if (n<=0) return;
+    std::vector<double> esf1Buf(n), esf2Buf(n), sfBuf(_kindCount*n);
+    double *esf1=&esf1Buf[0], *esf2=&esf2Buf[0];
+    for (unsigned int iev=0; iev<fEvents.size(); ++iev) {
+      const EsfToyEvent_t &ev=fEvents[iev];
+
+      for (int i=0; i<n; ++i) { esf1[i]=1.; esf2[i]=1.; }
+      for (int kind=0; kind<_nEffKinds; ++kind) {
+	double *sf=&sfBuf[kind*n];
+	const double *t1=&fSF[sfIndex(kind,ev.sfIdx1)+firstExp];
+	const double *t2=&fSF[sfIndex(kind,ev.sfIdx2)+firstExp];
+	for (int i=0; i<n; ++i) {
+	  sf[i]=sqrt(t1[i]*t2[i]);
+	  esf1[i]*=t1[i]; esf2[i]*=t2[i];
+	}
+      }
+      double *esf=&sfBuf[_kindEvent*n];
+      for (int i=0; i<n; ++i) esf[i]=esf1[i]*esf2[i];
+
+      const double w=ev.weight;
+      for (int kind=0; kind<_kindCount; ++kind) {
+	const double *x=&sfBuf[kind*n];
+	double *sumW =&fSumW [momIndex(ev.massBin,kind)+firstExp];
+	double *sumWX=&fSumWX[momIndex(ev.massBin,kind)+firstExp];
+	accumulate(n,x,w,sumW,sumWX);
+	if (ev.flatIdx>=0) {
+	  sumW =&fSumWFI [momIndex(ev.flatIdx,kind)+firstExp];
+	  sumWX=&fSumWXFI[momIndex(ev.flatIdx,kind)+firstExp];
+	  accumulate(n,x,w,sumW,sumWX);
+	}
+      }
+      if (ev.flatIdx>=0) {
+	double *evtW=&fEsfEvtWFI[ev.flatIdx*fNExps+firstExp];
+	for (int i=0; i<n; ++i) evtW[i]+=w*esf[i];
+	if (ev.zPeak) {
+	  double *zW=&fEsfEvtWZpeak[firstExp];
+	  for (int i=0; i<n; ++i) zW[i]+=w*esf[i];
+	}
+      }
+    }
+  }
+
+  // --------------------
+
+  // Process all pseudo-experiments. Returns 0 on error
+  int run(int nThreads=1) {
+    if (fSF.size()==0) {
+      std::cout << "EsfPseudoExperiments::run: call prepare() first\n";
+      return 0;
+    }
+    if (nThreads>fNExps) nThreads=fNExps;
+    if (nThreads<=1) {
+      process(0,fNExps);
+      return 1;
+    }
+    TThread::Initialize();
+    std::vector<ThreadArg_t> args(nThreads);
+    std::vector<TThread*> threads;
+    for (int ith=0; ith<nThreads; ++ith) {
+      args[ith].toys=this;
+      args[ith].firstExp= (fNExps*ith)/nThreads;
+      args[ith].lastExp = (fNExps*(ith+1))/nThreads;
+      threads.push_back(new TThread(Form("esfToys_%d",ith),
+				    EsfPseudoExperiments_t::runThread,
+				    (void*)&args[ith]));
+      threads.back()->Run();
+    }
+    for (int ith=0; ith<nThreads; ++ith) {
+      threads[ith]->Join();
+      delete threads[ith];
+    }
+    return 1;
+  }
+
+  // --------------------
+  // results
+
+  // mean scale factor of a pseudo-experiment, for the mass bin or flat index
+  double mean(int flatIndexing, int ibin, int kind, int iexp) const {
+    const std::vector<double> &sumW = (flatIndexing) ? fSumWFI  : fSumW;
+    const std::vector<double> &sumWX= (flatIndexing) ? fSumWXFI : fSumWX;
+    const int i=momIndex(ibin,kind)+iexp;
+    return (sumW[i]==0.) ? 0. : sumWX[i]/sumW[i];
+  }
+
+  double esfEvtW(int flatIdx, int iexp) const { return fEsfEvtWFI[flatIdx*fNExps+iexp]; }
+  double esfEvtWZpeak(int iexp) const { return fEsfEvtWZpeak[iexp]; }
+
+protected:
+  struct ThreadArg_t {
+    EsfPseudoExperiments_t *toys;
+    int firstExp, lastExp;
+  };
+
+  static void* runThread(void *arg) {
+    ThreadArg_t *a=(ThreadArg_t*)arg;
+    a->toys->process(a->firstExp,a->lastExp);
+    return NULL;
+  }
+
+  int sfIndex(int kind, int etEtaIdx) const {
+    return (kind*(fEtBinCount*fEtaBinCount+1) + etEtaIdx)*fNExps;
+  }
+
+  int momIndex(int ibin, int kind) const {
+    return (ibin*_kindCount + kind)*fNExps;
+  }
+
+  void accumulate(int n, const double *x, double w, double *sumW, double *sumWX) const {
+    const double lo=fLowLimit, hi=fHighLimit;
+    for (int i=0; i<n; ++i) {
+      const double wi= ((x[i]>=lo) && (x[i]<hi)) ? w : 0.;
+      sumW[i] += wi;
+      sumWX[i]+= wi*x[i];
+    }
+  }
+};
+
+// --------------------------------------------------------
+
+#endif
@@ -23,6 +23,13 @@ fi
 
 collectEvents=1 # recommended to have it set to 1. calcEventEff prepares skim fil
 
+# pseudo-experiments for the scale factor errors in calcEventEff
+esfToys=100
+esfToyThreads=4
+
+# bins fitted in parallel (forked processes) in the tag-and-probe fits
+tnpFitJobs=4
+
 # if you do not want to have the time stamp, comment the line away 
 # or set timeStamp=
 timeStamp="-`date +%Y%m%d-%H%M`"
@@ -145,7 +152,7 @@ runEffReco() {
  dataKind=${inpFile/data/}
  if [ ${#dataKind} -eq ${#inpFile} ] ; then dataKind="mc"; else dataKind="data"; fi
 # calculate
- root -b -q -l  eff_Reco.C+\(\"${inpFile}\",\"RECO\",\"${triggerSet}\",${puReweight},${debugMode}\) \
+ root -b -q -l  eff_Reco.C+\(\"${inpFile}\",\"RECO\",\"${triggerSet}\",${puReweight},${debugMode},${tnpFitJobs}\) \
      | tee log${timeStamp}-${dataKind}-RECO-puW${puReweight}.out
   if [ $? != 0 ] ; then noError=0;
   else
@@ -163,7 +170,7 @@ runEffIdHlt() {
  effKind=$1
  if [ ${#dataKind} -eq ${#inpFile} ] ; then dataKind="mc"; else dataKind="data"; fi
 # calculate
- root -b -q -l  eff_IdHlt.C+\(\"${inpFile}\",\"${effKind}\",\"${triggerSet}\",${puReweight},${debugMode}\) \
+ root -b -q -l  eff_IdHlt.C+\(\"${inpFile}\",\"${effKind}\",\"${triggerSet}\",${puReweight},${debugMode},${tnpFitJobs}\) \
      | tee log${timeStamp}-${dataKind}-${effKind}-puW${puReweight}.out
   if [ $? != 0 ] ; then noError=0;
   else 
@@ -179,7 +186,7 @@ runEffIdHlt() {
 runCalcEventEff() {
  _collectEvents=$1
  if [ ${#_collectEvents} -eq 0 ] ; then _collectEvents=1; fi
- root -b -q -l  calcEventEff.C+\(\"${mcConfInputFile}\",\"${tnpDataFile}\",\"${tnpMCFile}\",\"${triggerSet}\",${_collectEvents},${puReweight},${debugMode}\) \
+ root -b -q -l  calcEventEff.C+\(\"${mcConfInputFile}\",\"${tnpDataFile}\",\"${tnpMCFile}\",\"${triggerSet}\",${_collectEvents},${puReweight},${debugMode},${esfToys},${esfToyThreads}\) \
      | tee log${timeStamp}-calcEventEff-puW${puReweight}.out
   if [ $? != 0 ] ; then noError=0;
   else 
@@ -1,7 +1,18 @@
 #if !defined(__CINT__) || defined(__MAKECINT__)
 #include "../Include/fitFunctions.hh"
 #include "../Include/MyTools.hh"
+#include "../EventScaleFactors/tnpProbeStore.hh"
 #include <TEntryList.h>
+#include <TEnv.h>
+#include <THLimitsFinder.h>
+#include <TSystem.h>
+#include <TKey.h>
+#include <TFrame.h>
+#include <TVectorD.h>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #endif
 
 const int targetSpecificBin=0;
@@ -185,8 +196,10 @@ void measureEfficiency(TTree *passTree, TTree *failTree,
 		       int NsetBins, DYTools::TEfficiencyKind_t effType, 
 		       const char* setBinsType, 
 		       TString dirTag, const TString &picFileExtraTag, 
-		       int puBin) {
+		       int puBin, const tnpProbeStore_t *store,
+		       int nParallelFits) {
   // puBin is important for the fit
+  // If the probe store is given, the trees are not used
 
   // For COUNTnCOUNT method we should write to root file results
   // from measureEfficiencyCountAndCount routine, otherwise
@@ -199,7 +212,7 @@ void measureEfficiency(TTree *passTree, TTree *failTree,
   measureEfficiencyCountAndCount(passTree, failTree, etBinning, etaBinning, 
 				 canvas, effOutput, 
 				 saveCountingToRootFile, resultsRootFile, 
-				 plotsRootFile, effType);
+				 plotsRootFile, effType, puBin, store);
   
   if( method == DYTools::COUNTnFIT || method == DYTools::FITnFIT ) {
     measureEfficiencyWithFit(passTree, failTree, 
@@ -208,7 +221,7 @@ void measureEfficiency(TTree *passTree, TTree *failTree,
 			     useTemplates, templatesFile, 
 			     resultsRootFile, plotsRootFile,
 			     NsetBins, effType, setBinsType, dirTag, 
-			     picFileExtraTag, puBin);
+			     picFileExtraTag, puBin, store, nParallelFits);
   }
   
 
@@ -225,7 +238,8 @@ void measureEfficiencyPU(TTree *passTreeFull, TTree *failTreeFull,
 			 int NsetBins, DYTools::TEfficiencyKind_t effType, 
 			 const char* setBinsType, 
 			 TString dirTag, const TString &picFileExtraTag,
-			 int puDependence
+			 int puDependence, const tnpProbeStore_t *store,
+			 int nParallelFits
 			 ) {
 
   if (!puDependence) {
@@ -238,7 +252,63 @@ void measureEfficiencyPU(TTree *passTreeFull, TTree *failTreeFull,
 		      canvas,effOutput,fitLog,useTemplates,
 		      templatesFile,resultsRootFile,resultPlotsFile,
 		      NsetBins,effType,setBinsType,
-		      dirTag,picFileExtraTag);
+		      dirTag,picFileExtraTag,-1,store,nParallelFits);
+  }
+  else if (store) {
+    // the PU bins are the slices of the probe store
+    effOutput << "\nEvent distribution by PU\n";
+    effOutput << "  PU range    passCount    failCount\n";
+    char buf[100];
+    Long64_t nPass=0, nFail=0;
+    for (int pu_i=0; pu_i<store->nPUBins(); ++pu_i) {
+      Long64_t count[2];
+      for (int pass=0; pass<2; ++pass) {
+	count[pass]=store->outsideCount(pass,pu_i);
+	for (int i=0; i<store->nEtBins(); ++i) {
+	  for (int j=0; j<store->nEtaBins(); ++j) {
+	    count[pass]+= store->groupEnd(pass,i,j,pu_i) - store->groupBegin(pass,i,j,pu_i);
+	  }
+	}
+      }
+      nPass+=count[1];
+      nFail+=count[0];
+      if (pu_i<DYTools::nPVBinCount) {
+	sprintf(buf,"  %4.1lf..%4.1lf    %8lld   %8lld", 
+		DYTools::nPVLimits[pu_i],DYTools::nPVLimits[pu_i+1],
+		count[1], count[0]);
+	effOutput << buf << "\n";
+      }
+      else {
+	sprintf(buf,"  excluded      %8lld   %8lld", count[1],count[0]);
+	effOutput << buf << "\n"
+		  <<"-------------------------------------\n";
+      }
+    }
+    sprintf(buf,"  total         %8lld   %8lld", nPass,nFail);
+    effOutput << buf << "\n";
+
+    // measure efficiency
+    for (int pu_i=0; pu_i<DYTools::nPVBinCount; ++pu_i) {
+      std::cout << " pu_i=" << pu_i << "\n";
+      UInt_t pvMin=UInt_t(DYTools::nPVLimits[pu_i  ]+0.6);
+      UInt_t pvMax=UInt_t(DYTools::nPVLimits[pu_i+1]-0.4);
+      sprintf(buf,"_%u_%u.root",pvMin,pvMax);
+      TString resRootFName=resultRootFileBase + TString(buf);
+      TFile *resultsRootFile=new TFile(resRootFName,"recreate");
+      sprintf(buf,"-plots_%u_%u.root",pvMin,pvMax);
+      TString resPlotFName=resultRootFileBase + TString(buf);
+      TFile *resultPlotFile=new TFile(resPlotFName,"recreate");
+      fitLog << "\nmeasureEfficiencyPU: PU range " 
+	     << pvMin << " - " << pvMax << " (probe store)\n";
+      effOutput << "\nmeasureEfficiencyPU: PU range " 
+		<< pvMin << " - " << pvMax << "\n";
+      measureEfficiency(NULL,NULL,
+			method,etBinning,etaBinning,
+			canvas,effOutput,fitLog,useTemplates,templatesFile,
+			resultsRootFile,resultPlotFile,
+			NsetBins,effType,setBinsType,
+			dirTag,picFileExtraTag, pu_i+1, store, nParallelFits);
+    }
   }
   else {
     // prepare pu-dependent trees
@@ -328,7 +398,7 @@ void measureEfficiencyPU(TTree *passTreeFull, TTree *failTreeFull,
 			canvas,effOutput,fitLog,useTemplates,templatesFile,
 			resultsRootFile,resultPlotFile,
 			NsetBins,effType,setBinsType,
-			dirTag,picFileExtraTag, pu_i+1);
+			dirTag,picFileExtraTag, pu_i+1, NULL, nParallelFits);
       std::cout << "done measure efficiency" << std::endl;
     }
 
@@ -338,39 +408,117 @@ void measureEfficiencyPU(TTree *passTreeFull, TTree *failTreeFull,
   return;
 }
 
-void measureEfficiencyCountAndCount(TTree *passTree, TTree *failTree, 
-			    int etBinning, int etaBinning, 
-			    TCanvas *canvas, ofstream &effOutput,
-			    bool saveResultsToRootFile, TFile *resultsRootFile,
-				    TFile *resultPlotsFile, 
-				    DYTools::TEfficiencyKind_t effType){
-  
+// --------------------------------------------------
+// Single-pass counting for measureEfficiencyCountAndCount.
+//
+// Each probe of passTree and failTree is read once and added to every
+// (Et,eta) cell it belongs to (the merged RECO eta bins overlap).
+// The cell limits are rounded as in the cut strings
+// "et >=%6.1f && et <%6.1f" and "eta >= %5.3f && eta < %5.3f" that
+// were given to TTree::GetEntries and TTree::Draw, thus the cells
+// contain exactly the same probes. The weight and mass values are kept
+// to build the histograms that TTree::Draw used to make.
+
+struct TnPCountCell_t {
+  double etMin, etMax, etaMin, etaMax;
+  int etBin, etaBinFirst, etaBinLast;   // the bins of the probe store
+  double count[2], sumW[2], sumW2[2];   // index: 0 - fail, 1 - pass
+  std::vector<double> weight[2], mass[2];
+
+  TnPCountCell_t(double et_min=0, double et_max=0, double eta_min=0, double eta_max=0,
+		 int et_bin=-1, int eta_bin_first=-1, int eta_bin_last=-1) :
+    etMin(et_min), etMax(et_max), etaMin(eta_min), etaMax(eta_max),
+    etBin(et_bin), etaBinFirst(eta_bin_first), etaBinLast(eta_bin_last)
+  {
+    for (int pass=0; pass<2; ++pass) { count[pass]=0; sumW[pass]=0; sumW2[pass]=0; }
+  }
+
+  bool contains(double et, double eta) const {
+    return ((et>=etMin) && (et<etMax) && (eta>=etaMin) && (eta<etaMax));
+  }
+
+  bool sameLimits(const TnPCountCell_t &c) const {
+    return ((etMin==c.etMin) && (etMax==c.etMax) && 
+	    (etaMin==c.etaMin) && (etaMax==c.etaMax));
+  }
+};
+
+// --------------------------------------------------
+
+// Reads the branches et, eta, mass and weight of a T&P tree only.
+// The branch addresses of the caller are restored by the destructor.
+// If the tree has no weight branch, the weight is 1
+
+class TnPProbeReader_t {
+  enum { _nBr=4 };
+  TTree *FTree;
+  TBranch *FBr[_nBr];
+  char *FKeepAddress[_nBr];
+  Double_t FValues[_nBr];
+public:
+  TnPProbeReader_t(TTree *tree) : FTree(tree) {
+    const char *brNames[_nBr] = { "et", "eta", "mass", "weight" };
+    for (int k=0; k<_nBr; ++k) {
+      FValues[k]=(k==3) ? 1. : 0.;
+      FKeepAddress[k]=NULL;
+      FBr[k]=tree->GetBranch(brNames[k]);
+      if (!FBr[k]) {
+	if (k==3) continue; // no weight branch: unit weights
+	std::cout << "TnPProbeReader_t: tree <" << tree->GetName() 
+		  << "> does not have branch <" << brNames[k] << ">\n";
+	assert(0);
+      }
+      FKeepAddress[k]=FBr[k]->GetAddress();
+      FBr[k]->SetAddress(&FValues[k]);
+    }
+  }
+
+  ~TnPProbeReader_t() {
+    for (int k=0; k<_nBr; ++k) {
+      if (!FBr[k]) continue;
+      if (FKeepAddress[k]) FBr[k]->SetAddress(FKeepAddress[k]);
+      else FBr[k]->ResetAddress();
+    }
+  }
+
+  Long64_t entries() const { return FTree->GetEntries(); }
+  bool hasWeight() const { return (FBr[3]) ? true : false; }
+  void getEntry(Long64_t ientry) {
+    for (int k=0; k<_nBr; ++k) if (FBr[k]) FBr[k]->GetEntry(ientry);
+  }
+
+  double et() const { return FValues[0]; }
+  double eta() const { return FValues[1]; }
+  double mass() const { return FValues[2]; }
+  double weight() const { return FValues[3]; }
+};
+
+// --------------------------------------------------
+
+double cutLimit_local(const char *format, double x) {
+  return atof(TString::Format(format,x).Data());
+}
+
+// --------------------------------------------------
+
+// Prepares the cells (i,j) -> cells[i + j*nEt] and their cut strings
+
+void prepareTnPCells_local(int etBinning, int etaBinning, 
+			   DYTools::TEfficiencyKind_t effType,
+			   std::vector<TnPCountCell_t> &cells,
+			   std::vector<TString> &cuts) {
   int nEt                = DYTools::getNEtBins(etBinning);
   const double *limitsEt = DYTools::getEtBinLimits(etBinning);
   
   int nEta                = DYTools::getNEtaBins(etaBinning);
   const double *limitsEta = DYTools::getEtaBinLimits(etaBinning);
-  printf("eta bins %d\n", nEta);
-
-  TMatrixD effArray2D(nEt, nEta);
-  TMatrixD effArrayErrLow2D(nEt, nEta);
-  TMatrixD effArrayErrHigh2D(nEt, nEta);
-  TMatrixD effArray2DWeighted(nEt, nEta);
-  TMatrixD effArrayErrLow2DWeighted(nEt, nEta);
-  TMatrixD effArrayErrHigh2DWeighted(nEt, nEta);
- 
-  std::vector<std::string> lines;
-  lines.reserve(50);
 
-  effOutput << endl;
-  effOutput << "Efficiency, counting method:\n";  
-  effOutput << "     SC ET         SC eta           efficiency             pass         fail\n";
-
-  lines.push_back("\nEfficiency, counting method (weighted):\n");
-  lines.push_back("     SC ET         SC eta           efficiency             pass         fail\n");
+  cells.clear();
+  cuts.clear();
+  cells.reserve(nEt*nEta);
+  cuts.reserve(nEt*nEta);
   for(int j=0; j<nEta; j++){
     for(int i=0; i<nEt; i++){
-      double effCount, effErrLowCount, effErrHighCount;
       TString etCut = TString::Format(" ( et >=%6.1f && et <%6.1f ) ",
 				      limitsEt[i], limitsEt[i+1]);
       TString etaCutFormat= DYTools::signedEtaBinning(etaBinning) ?
@@ -379,22 +527,15 @@ void measureEfficiencyCountAndCount(TTree *passTree, TTree *failTree,
 
       double limitsEtaMin = limitsEta[j];
       double limitsEtaMax = limitsEta[j+1];	  
+      int etaBinFirst=j, etaBinLast=j;
       // For RECO efficiency, to increase fit stability, MERGE barrel
       // eta bins, and separately endcap eta bins, for the binning ETABINS5
       // and Et < 20 GeV
       //
-      // While this is count and count method with no fit involved, the change
-      // is made here as well to match the corresponding change in the
-      // measureEfficiencyWithFit(...) function, so that the averaging over
+      // While this is needed for the fits, the change is made for the
+      // count and count method as well, so that the averaging over
       // the eta bins is the same.
       //
-      // In the way it is implemented now, there is duplication of work.
-      // For example, when the eta bins 0.0-0.8 and 0.8-1.4442 are merged,
-      // we do the full fitting of the data in 0.0-1.4442 twice,
-      // once for j=0, and then again for j=1. The result of this will be identical
-      // and some CPU will be wasted. However, the bookkeeping this way is much
-      // easier, and the code is easier to read. This can be changed in the 
-      // future if needed.
       //   Since the binning is not changed, the entries in the efficiency array
       // will be exactly the same for the merged bins. 
       //   The calculation of the error on the event-level scale factors as 
@@ -406,14 +547,14 @@ void measureEfficiencyCountAndCount(TTree *passTree, TTree *failTree,
 	  // Barrel eta bins
 	  limitsEtaMin = limitsEta[0];
 	  limitsEtaMax = limitsEta[2];
-	  printf("MERGE two barrel eta bins j=0 j=1 into one. The efficiency measurement\n");
-	  printf("      is done twice with identical data, this is the instance j=%d\n", j);
+	  etaBinFirst=0; etaBinLast=1;
+	  printf("MERGE two barrel eta bins j=0 j=1 into one. This is the instance j=%d for Et bin i=%d\n", j,i);
 	} else if ( j ==3 || j ==4 ) {
 	  // Endcap eta bins
 	  limitsEtaMin = limitsEta[3];
 	  limitsEtaMax = limitsEta[5];
-	  printf("MERGE two endcap eta bins j=3 j=4 into one. The efficiency measurement\n");
-	  printf("      is done twice with identical data, this is the instance j=%d\n", j);
+	  etaBinFirst=3; etaBinLast=4;
+	  printf("MERGE two endcap eta bins j=3 j=4 into one. This is the instance j=%d for Et bin i=%d\n", j,i);
 	} else {
 	  // Anything else (really, the rapidity gap, j==2)
 	  // No need to set anything, set above in declaration/initialization
@@ -422,24 +563,175 @@ void measureEfficiencyCountAndCount(TTree *passTree, TTree *failTree,
 
       TString etaCut = TString::Format( etaCutFormat,
 					limitsEtaMin, limitsEtaMax);
-      TString cut = etCut + TString(" && ") + etaCut;
-      //cout << cut << endl;
-      double probesPass = passTree->GetEntries(cut);
-      double probesFail = failTree->GetEntries(cut);
+      cuts.push_back(etCut + TString(" && ") + etaCut);
+      cells.push_back(TnPCountCell_t(cutLimit_local("%6.1f",limitsEt[i]),
+				     cutLimit_local("%6.1f",limitsEt[i+1]),
+				     cutLimit_local("%5.3f",limitsEtaMin),
+				     cutLimit_local("%5.3f",limitsEtaMax),
+				     i, etaBinFirst, etaBinLast));
+    }
+  }
+}
 
-      // padIdx = 1 + 2*(i + j*nEt)
-      int padIdx= 1 + ( (2*i + 2*j*nEt) % (2*DYTools::maxTnPCanvasDivisions) );
-      canvas->cd(padIdx);
-      passTree->Draw("weight >> hwPass",cut);
-      canvas->cd(padIdx+1);
-      failTree->Draw("weight >> hwFail",cut);
-      TH1 *hwPass=(TH1*)gDirectory->Get("hwPass");
-      TH1 *hwFail=(TH1*)gDirectory->Get("hwFail");
-      double probesPassWeighted = hwPass->GetMean() * hwPass->GetEntries();
-      double probesFailWeighted = hwFail->GetMean() * hwFail->GetEntries();
+// --------------------------------------------------
+
+void fillTnPCountCells_local(TTree *tree, int pass, bool absEta,
+			     std::vector<TnPCountCell_t> &cells) {
+  TnPProbeReader_t probe(tree);
+  const Long64_t nEntries=probe.entries();
+  for (Long64_t ientry=0; ientry<nEntries; ++ientry) {
+    probe.getEntry(ientry);
+    const double et=probe.et();
+    const double eta=(absEta) ? fabs(probe.eta()) : probe.eta();
+    const double w=probe.weight();
+    for (unsigned int ic=0; ic<cells.size(); ++ic) {
+      TnPCountCell_t &cell=cells[ic];
+      if (!cell.contains(et,eta)) continue;
+      cell.count[pass]+=1;
+      cell.sumW[pass]+=w;
+      cell.sumW2[pass]+=w*w;
+      cell.weight[pass].push_back(w);
+      cell.mass[pass].push_back(probe.mass());
+    }
+  }
+}
+
+// --------------------------------------------------
+
+// The same from the probe store: the probes of a cell are the slices
+// of its store bins, PU bins puFirst..puLast
+
+void fillTnPCountCellsFromStore_local(const tnpProbeStore_t &store, int pass,
+				      int puFirst, int puLast,
+				      std::vector<TnPCountCell_t> &cells) {
+  for (unsigned int ic=0; ic<cells.size(); ++ic) {
+    TnPCountCell_t &cell=cells[ic];
+    for (int j=cell.etaBinFirst; j<=cell.etaBinLast; ++j) {
+      const Long64_t iEnd=store.groupEnd(pass,cell.etBin,j,puLast);
+      for (Long64_t i=store.groupBegin(pass,cell.etBin,j,puFirst); i<iEnd; ++i) {
+	const double w=store.weight(i);
+	cell.count[pass]+=1;
+	cell.sumW[pass]+=w;
+	cell.sumW2[pass]+=w*w;
+	cell.weight[pass].push_back(w);
+	cell.mass[pass].push_back(store.mass(i));
+      }
+    }
+  }
+}
+
+// --------------------------------------------------
+
+// The store PU bins for the puBin of measureEfficiency (1-based, or
+// -1 for all probes)
+
+void storePURange_local(const tnpProbeStore_t &store, int puBin,
+			int &puFirst, int &puLast) {
+  if (puBin>0) { puFirst=puBin-1; puLast=puBin-1; }
+  else { puFirst=0; puLast=store.nPUBins()-1; }
+}
+
+// --------------------------------------------------
+
+// TTree::GetEstimate, or the TTree default if the tree is not given
+
+Long64_t treeEstimate_local(const TTree *tree) {
+  return (tree) ? tree->GetEstimate() : Long64_t(1000000);
+}
+
+// --------------------------------------------------
+
+// The histogram as made by TTree::Draw("var"): default number of bins,
+// the range is found from the first tree->GetEstimate() values and
+// the axis is extended for the later values
+
+TH1F* makeDrawLikeHisto_local(const TString &name, const TString &title,
+			      const std::vector<double> &values, 
+			      Long64_t estimate) {
+  const int nBins=gEnv->GetValue("Hist.Binning.1D.x",100);
+  TH1F *h=new TH1F(name,title,nBins,0.,0.);
+  if (values.size()) {
+    const unsigned int nEst=(estimate>0 && (unsigned int)(estimate)<values.size()) ? (unsigned int)(estimate) : values.size();
+    double vmin=values[0], vmax=values[0];
+    for (unsigned int i=1; i<nEst; ++i) {
+      if (values[i]<vmin) vmin=values[i];
+      if (values[i]>vmax) vmax=values[i];
+    }
+    h->SetBuffer(0);
+    THLimitsFinder::GetLimitsFinder()->FindGoodLimits(h,vmin,vmax);
+    h->SetBit(TH1::kCanRebin);
+    h->FillN(values.size(),&values[0],NULL);
+  }
+  return h;
+}
+
+// --------------------------------------------------
+
+void measureEfficiencyCountAndCount(TTree *passTree, TTree *failTree, 
+			    int etBinning, int etaBinning, 
+			    TCanvas *canvas, ofstream &effOutput,
+			    bool saveResultsToRootFile, TFile *resultsRootFile,
+				    TFile *resultPlotsFile, 
+				    DYTools::TEfficiencyKind_t effType,
+				    int puBin, const tnpProbeStore_t *store){
+  
+  int nEt                = DYTools::getNEtBins(etBinning);
+  const double *limitsEt = DYTools::getEtBinLimits(etBinning);
+  
+  int nEta                = DYTools::getNEtaBins(etaBinning);
+  const double *limitsEta = DYTools::getEtaBinLimits(etaBinning);
+  printf("eta bins %d\n", nEta);
+
+  TMatrixD effArray2D(nEt, nEta);
+  TMatrixD effArrayErrLow2D(nEt, nEta);
+  TMatrixD effArrayErrHigh2D(nEt, nEta);
+  TMatrixD effArray2DWeighted(nEt, nEta);
+  TMatrixD effArrayErrLow2DWeighted(nEt, nEta);
+  TMatrixD effArrayErrHigh2DWeighted(nEt, nEta);
+
+  // Prepare the cells (i,j) -> cells[i + j*nEt]
+  const bool absEta= !DYTools::signedEtaBinning(etaBinning);
+  std::vector<TnPCountCell_t> cells;
+  std::vector<TString> cuts;
+  prepareTnPCells_local(etBinning, etaBinning, effType, cells, cuts);
+
+  // Count the probes: one pass over each tree, or the slices of the
+  // probe store
+  if (store) {
+    if (!store->matches(etBinning,etaBinning)) {
+      std::cout << "measureEfficiencyCountAndCount: the probe store has a different binning\n";
+      assert(0);
+    }
+    int puFirst, puLast;
+    storePURange_local(*store,puBin,puFirst,puLast);
+    fillTnPCountCellsFromStore_local(*store, 0, puFirst, puLast, cells);
+    fillTnPCountCellsFromStore_local(*store, 1, puFirst, puLast, cells);
+  }
+  else {
+    fillTnPCountCells_local(failTree, 0, absEta, cells);
+    fillTnPCountCells_local(passTree, 1, absEta, cells);
+  }
+ 
+  std::vector<std::string> lines;
+  lines.reserve(50);
+
+  effOutput << endl;
+  effOutput << "Efficiency, counting method:\n";  
+  effOutput << "     SC ET         SC eta           efficiency             pass         fail\n";
+
+  lines.push_back("\nEfficiency, counting method (weighted):\n");
+  lines.push_back("     SC ET         SC eta           efficiency             pass         fail\n");
+  for(int j=0; j<nEta; j++){
+    for(int i=0; i<nEt; i++){
+      double effCount, effErrLowCount, effErrHighCount;
+      TnPCountCell_t &cell= cells[i + j*nEt];
+      const TString &cut= cuts[i + j*nEt];
+      double probesPass = cell.count[1];
+      double probesFail = cell.count[0];
+      double probesPassWeighted = cell.sumW[1];
+      double probesFailWeighted = cell.sumW[0];
       double effCountWeighted, effErrLowCountWeighted, effErrHighCountWeighted;
       //std::cout << " probesPass=" << probesPass << ", probesFail=" << probesFail << "\n";
-      //std::cout << " hwPass->GetEntries=" << hwPass->GetEntries() << ", hwFail->GetEntries=" << hwFail->GetEntries() << "\n";
       //std::cout << " probesPassWeighted=" << probesPassWeighted << ", probesFailWeighted=" << probesFailWeighted << "\n";
 
       DYTools::calcEfficiency( probesPass, probesPass+probesFail, 
@@ -455,12 +747,14 @@ void measureEfficiencyCountAndCount(TTree *passTree, TTree *failTree,
       snprintf(strOut,len, "hweightPass_Et_%1.0f-%1.0f__Eta_%5.3f-%5.3f",
 	      limitsEt[i],limitsEt[i+1],
 	      limitsEta[j],limitsEta[j+1]);
-      hwPass->SetName(strOut);
+      TH1F *hwPass=makeDrawLikeHisto_local(strOut, TString("weight {") + cut + TString("}"),
+					   cell.weight[1], treeEstimate_local(passTree));
       if (resultPlotsFile) { resultPlotsFile->cd(); hwPass->Write(); }
       snprintf(strOut,len, "hweightFail_Et_%1.0f-%1.0f__Eta_%5.3f-%5.3f",
 	      limitsEt[i],limitsEt[i+1],
 	      limitsEta[j],limitsEta[j+1]);
-      hwFail->SetName(strOut);
+      TH1F *hwFail=makeDrawLikeHisto_local(strOut, TString("weight {") + cut + TString("}"),
+					   cell.weight[0], treeEstimate_local(failTree));
       if (resultPlotsFile) { resultPlotsFile->cd(); hwFail->Write(); }
 
       snprintf(strOut,len, "   %3.0f - %3.0f   %5.3f - %5.3f   %5.1f +%5.1f -%5.1f    %10.0f  %10.0f\n",
@@ -478,12 +772,22 @@ void measureEfficiencyCountAndCount(TTree *passTree, TTree *failTree,
 	      probesPassWeighted, probesFailWeighted);
       lines.push_back(strOut);
 
+      // mass distributions (as by TTree::Draw("mass",cut))
+      TH1F *hmPass=makeDrawLikeHisto_local("htemp", TString("mass {") + cut + TString("}"),
+					   cell.mass[1], treeEstimate_local(passTree));
+      TH1F *hmFail=makeDrawLikeHisto_local("htemp", TString("mass {") + cut + TString("}"),
+					   cell.mass[0], treeEstimate_local(failTree));
+      hmPass->SetDirectory(0);
+      hmFail->SetDirectory(0);
+      hmPass->GetXaxis()->SetTitle("mass");
+      hmFail->GetXaxis()->SetTitle("mass");
+
       // padIdx = 1 + 2*(i + j*nEt)
-      padIdx= 1 + ( (2*i + 2*j*nEt) % (2*DYTools::maxTnPCanvasDivisions) );
+      int padIdx= 1 + ( (2*i + 2*j*nEt) % (2*DYTools::maxTnPCanvasDivisions) );
       canvas->cd(padIdx);
-      passTree->Draw("mass",cut);
+      hmPass->DrawCopy();
       canvas->cd(padIdx+1);
-      failTree->Draw("mass",cut);
+      hmFail->DrawCopy();
       canvas->Update();
       if (resultPlotsFile) {
 	resultPlotsFile->cd();
@@ -493,10 +797,17 @@ void measureEfficiencyCountAndCount(TTree *passTree, TTree *failTree,
 	canvName.ReplaceAll(".","_");
 	TCanvas ctemp(canvName,canvName,900,400);
 	ctemp.Divide(2,1);
-	ctemp.cd(1); passTree->Draw("mass",cut);
-	ctemp.cd(2); failTree->Draw("mass",cut);
+	ctemp.cd(1); hmPass->DrawCopy();
+	ctemp.cd(2); hmFail->DrawCopy();
 	ctemp.Write();
       }
+      delete hmPass;
+      delete hmFail;
+      // the probes of the cell are not needed anymore
+      std::vector<double>().swap(cell.mass[0]);
+      std::vector<double>().swap(cell.mass[1]);
+      std::vector<double>().swap(cell.weight[0]);
+      std::vector<double>().swap(cell.weight[1]);
 
       // Add systematics for HLT efficiency (see comments at the top
       // when the arrays are introduced
@@ -550,6 +861,302 @@ void measureEfficiencyCountAndCount(TTree *passTree, TTree *failTree,
   return;
 }
 
+// --------------------------------------------------
+// Bin-parallel fits for measureEfficiencyWithFit.
+//
+// The fits of different (Et,eta) bins are independent. Each fit is done
+// on in-memory trees that contain only the probes of the bin (sliced in
+// one pass over passTree and failTree). RooFit and Minuit are not
+// thread-safe, therefore the fits run in forked processes, at most
+// nParallelFits at a time. A job draws into the pads of a private
+// canvas and saves its plots, pads, fit log and efficiency into
+// temporary files. The parent collects the jobs in bin order, thus the
+// canvas, the plots file and the fit log follow the order of the serial
+// loop. The merged RECO eta bins are fitted once and the result is used
+// for both bins.
+//   With nParallelFits=1 the jobs run one by one in this process.
+
+struct TnPFitSettings_t {
+  int method, NsetBins;
+  bool isRECO, useTemplates;
+  TString setBinsType, dirTag, picFileExtraTag;
+};
+
+struct TnPFitJob_t {
+  int i, j, padIdx;        // the first bin that needs this fit
+  TString cut;
+  TTree *passSlice, *failSlice;
+  TH1F *templatePass, *templateFail;
+  TString tmpFileBase;
+  int status;              // 0 - not done, 1 - done, -1 - failed
+};
+
+// --------------------------------------------------
+
+TString tnpFitHeader_local(int etBinning, int etaBinning, int i, int j) {
+  const double *limitsEt = DYTools::getEtBinLimits(etBinning);
+  const double *limitsEta = DYTools::getEtaBinLimits(etaBinning);
+  return TString::Format(" ==   Start fitting Et: %3.0f - %3.0f  and eta:  %5.3f - %5.3f \n",
+			 limitsEt[i], limitsEt[i+1],
+			 limitsEta[j], limitsEta[j+1]);
+}
+
+// --------------------------------------------------
+
+// Copies the probes of the listed cells into in-memory trees
+
+void sliceTnPTree_local(TTree *tree, bool absEta, 
+			const std::vector<TnPCountCell_t> &cells,
+			const std::vector<int> &cellIdx,
+			std::vector<TTree*> &slices, const char *namePrefix) {
+  TnPProbeReader_t probe(tree);
+  Double_t mass, et, eta, weight;
+  slices.clear();
+  slices.reserve(cellIdx.size());
+  for (unsigned int k=0; k<cellIdx.size(); ++k) {
+    TString name=TString::Format("%s_%d",namePrefix,cellIdx[k]);
+    TTree *slice=new TTree(name,name);
+    slice->SetDirectory(0);
+    slice->Branch("mass",&mass,"mass/D");
+    slice->Branch("et",&et,"et/D");
+    slice->Branch("eta",&eta,"eta/D");
+    if (probe.hasWeight()) slice->Branch("weight",&weight,"weight/D");
+    slices.push_back(slice);
+  }
+
+  const Long64_t nEntries=probe.entries();
+  for (Long64_t ientry=0; ientry<nEntries; ++ientry) {
+    probe.getEntry(ientry);
+    mass=probe.mass(); et=probe.et(); eta=probe.eta(); weight=probe.weight();
+    const double etaCell=(absEta) ? fabs(eta) : eta;
+    for (unsigned int k=0; k<cellIdx.size(); ++k) {
+      if (cells[cellIdx[k]].contains(et,etaCell)) slices[k]->Fill();
+    }
+  }
+}
+
+// --------------------------------------------------
+
+// The same from the probe store
+
+void sliceTnPStore_local(const tnpProbeStore_t &store, int pass,
+			 int puFirst, int puLast,
+			 const std::vector<TnPCountCell_t> &cells,
+			 const std::vector<int> &cellIdx,
+			 std::vector<TTree*> &slices, const char *namePrefix) {
+  slices.clear();
+  slices.reserve(cellIdx.size());
+  for (unsigned int k=0; k<cellIdx.size(); ++k) {
+    const TnPCountCell_t &cell=cells[cellIdx[k]];
+    TString name=TString::Format("%s_%d",namePrefix,cellIdx[k]);
+    slices.push_back(store.makeTree(name, pass, cell.etBin, 
+				    cell.etaBinFirst, cell.etaBinLast,
+				    puFirst, puLast));
+  }
+}
+
+// --------------------------------------------------
+
+// Performs the fit of the job. Returns 1 on success
+
+int runTnPFitJob_local(const TnPFitJob_t &job, const TnPFitSettings_t &st,
+		       const TString &header, TCanvas *canvas) {
+  TFile fout(job.tmpFileBase + TString(".root"),"recreate");
+  std::ofstream flog((job.tmpFileBase + TString(".log")).Data());
+  if (!fout.IsOpen() || !flog.is_open()) {
+    std::cout << "runTnPFitJob: failed to create the files <" 
+	      << job.tmpFileBase << ".*>\n";
+    return 0;
+  }
+
+  // a private canvas with the layout of the main canvas
+  int nPads=0;
+  while (canvas->GetPad(nPads+1)) nPads++;
+  TCanvas jobCanvas("tnpFitJobCanvas","tnpFitJobCanvas",
+		    canvas->GetWw(),canvas->GetWh());
+  jobCanvas.Divide(2,nPads/2);
+  TPad *passPad = (TPad*)jobCanvas.GetPad(job.padIdx);
+  TPad *failPad = (TPad*)jobCanvas.GetPad(job.padIdx + 1);
+  passPad->SetName(canvas->GetPad(job.padIdx)->GetName());
+  failPad->SetName(canvas->GetPad(job.padIdx+1)->GetName());
+
+  printf("\n ==\n");
+  printf("%s",header.Data());
+  printf(" ==\n\n");
+
+  double efficiency=0, efficiencyErrHi=0, efficiencyErrLo=0;
+  if (!st.useTemplates) {
+    fitMass(job.passSlice, job.failSlice, job.cut, st.method, 
+	    efficiency,efficiencyErrHi, efficiencyErrLo, passPad, failPad, 
+	    &fout, flog, st.NsetBins, st.isRECO, st.setBinsType, st.dirTag,
+	    false);
+  }
+  else {
+    printf("\nMASS TEMPLATES ARE USED IN THE FIT\n\n");
+    fitMassWithTemplates(job.passSlice, job.failSlice, job.cut, st.method, 
+			 efficiency, efficiencyErrHi, efficiencyErrLo,
+			 passPad, failPad, &fout,
+			 flog, job.templatePass, job.templateFail, 
+			 st.isRECO, st.setBinsType, st.dirTag, 
+			 st.picFileExtraTag, false);
+  }
+
+  TVectorD result(3);
+  result[0]=efficiency;
+  result[1]=efficiencyErrHi;
+  result[2]=efficiencyErrLo;
+  fout.cd();
+  result.Write("tnpFitResult");
+  passPad->Write("tnpFitPassPad");
+  failPad->Write("tnpFitFailPad");
+  fout.Close();
+  flog.close();
+  return 1;
+}
+
+// --------------------------------------------------
+
+// Runs the jobs in at most nProcesses forked processes
+
+void runTnPFitJobs_local(std::vector<TnPFitJob_t> &jobs, 
+			 const TnPFitSettings_t &st,
+			 const std::vector<TString> &headers,
+			 TCanvas *canvas, int nProcesses) {
+  if (nProcesses<1) nProcesses=1;
+  std::vector<pid_t> pids(jobs.size(),0);
+  unsigned int next=0;
+  int running=0;
+  while ((next<jobs.size()) || (running>0)) {
+    if ((next<jobs.size()) && (running<nProcesses)) {
+      const unsigned int k=next++;
+      pid_t pid=-1;
+      if (nProcesses>1) {
+	// the buffers would be flushed by the child otherwise
+	fflush(stdout);
+	std::cout.flush();
+	pid=fork();
+      }
+      if (pid==0) {
+	int ok=runTnPFitJob_local(jobs[k],st,headers[k],canvas);
+	fflush(stdout);
+	std::cout.flush();
+	_exit((ok) ? 0 : 1);
+      }
+      if (pid<0) {
+	// serial execution or fork failure
+	jobs[k].status=(runTnPFitJob_local(jobs[k],st,headers[k],canvas)) ? 1 : -1;
+      }
+      else {
+	pids[k]=pid;
+	running++;
+      }
+      continue;
+    }
+    int status=0;
+    pid_t pid=waitpid(-1,&status,0);
+    if (pid<=0) {
+      std::cout << "runTnPFitJobs: waitpid failed\n";
+      break;
+    }
+    for (unsigned int k=0; k<jobs.size(); ++k) {
+      if (pids[k]!=pid) continue;
+      jobs[k].status=(WIFEXITED(status) && (WEXITSTATUS(status)==0)) ? 1 : -1;
+      pids[k]=0;
+      running--;
+    }
+  }
+
+  for (unsigned int k=0; k<jobs.size(); ++k) {
+    if (jobs[k].status!=1) {
+      std::cout << "runTnPFitJobs: the fit " << headers[k] << " failed\n";
+      assert(0);
+    }
+  }
+}
+
+// --------------------------------------------------
+
+bool keySeekLess_local(const TKey *a, const TKey *b) {
+  return (a->GetSeekKey() < b->GetSeekKey());
+}
+
+// --------------------------------------------------
+
+// Transfers the job output to the main canvas pads, to the plots file
+// and to the fit log. The pads saved by the fit get the names of the
+// pads of the bin
+
+void collectTnPFitJob_local(const TnPFitJob_t &job, int padIdx, 
+			    TCanvas *canvas, TFile *resultPlotsFile, 
+			    ofstream &fitLog, double &efficiency, 
+			    double &efficiencyErrHi, double &efficiencyErrLo) {
+  std::ifstream flog((job.tmpFileBase + TString(".log")).Data());
+  if (flog.is_open()) {
+    fitLog << flog.rdbuf();
+    flog.close();
+  }
+
+  TFile fin(job.tmpFileBase + TString(".root"),"read");
+  if (!fin.IsOpen()) {
+    std::cout << "collectTnPFitJob: failed to open <" << fin.GetName() << ">\n";
+    assert(0);
+  }
+  TVectorD *result=(TVectorD*)fin.Get("tnpFitResult");
+  if (!result) {
+    std::cout << "collectTnPFitJob: no result in <" << fin.GetName() << ">\n";
+    assert(0);
+  }
+  efficiency=(*result)[0];
+  efficiencyErrHi=(*result)[1];
+  efficiencyErrLo=(*result)[2];
+  delete result;
+
+  const TString jobPassPadName=canvas->GetPad(job.padIdx)->GetName();
+  const TString jobFailPadName=canvas->GetPad(job.padIdx+1)->GetName();
+  TPad *passPad = (TPad*)canvas->GetPad(padIdx);
+  TPad *failPad = (TPad*)canvas->GetPad(padIdx + 1);
+
+  // plots, in the order they were written
+  if (resultPlotsFile) {
+    std::vector<TKey*> keys;
+    TIter nextKey(fin.GetListOfKeys());
+    TKey *key;
+    while ((key=(TKey*)nextKey())) {
+      if (TString(key->GetName()).BeginsWith("tnpFit")) continue;
+      keys.push_back(key);
+    }
+    std::sort(keys.begin(),keys.end(),keySeekLess_local);
+    for (unsigned int k=0; k<keys.size(); ++k) {
+      TObject *obj=keys[k]->ReadObj();
+      TString name=obj->GetName();
+      if (name==jobPassPadName) name=passPad->GetName();
+      else if (name==jobFailPadName) name=failPad->GetName();
+      resultPlotsFile->cd();
+      obj->Write(name);
+      delete obj;
+    }
+  }
+
+  // the fit plots on the main canvas
+  for (int pass=1; pass>=0; --pass) {
+    TPad *jobPad=(TPad*)fin.Get((pass) ? "tnpFitPassPad" : "tnpFitFailPad");
+    TPad *pad=(pass) ? passPad : failPad;
+    pad->cd();
+    pad->Clear();
+    if (jobPad) {
+      TIter nextPrim(jobPad->GetListOfPrimitives());
+      TObject *prim;
+      while ((prim=nextPrim())) {
+	if (prim->InheritsFrom(TFrame::Class())) continue;
+	prim->DrawClone(nextPrim.GetOption());
+      }
+      delete jobPad;
+    }
+    pad->Update();
+  }
+  fin.Close();
+}
+
 // --------------------------------------------------
 
 void measureEfficiencyWithFit(TTree *passTree, TTree *failTree, 
@@ -560,7 +1167,8 @@ void measureEfficiencyWithFit(TTree *passTree, TTree *failTree,
 			      int NsetBins, DYTools::TEfficiencyKind_t effType,
 			      const char* setBinsType, 
 			      TString dirTag, const TString &picFileExtraTag,
-			      int puBin){
+			      int puBin, const tnpProbeStore_t *store,
+			      int nParallelFits){
   
   int nEt                = DYTools::getNEtBins(etBinning);
   const double *limitsEt = DYTools::getEtBinLimits(etBinning);
@@ -594,155 +1202,141 @@ void measureEfficiencyWithFit(TTree *passTree, TTree *failTree,
     effOutput << msg;
   }
 
+  // The cells (i,j) -> cells[i + j*nEt]. The RECO eta bins are merged
+  // for Et<20 GeV (see prepareTnPCells_local)
+  const bool absEta= !DYTools::signedEtaBinning(etaBinning);
+  std::vector<TnPCountCell_t> cells;
+  std::vector<TString> cuts;
+  prepareTnPCells_local(etBinning, etaBinning, effType, cells, cuts);
+
+  // Determine the fits. A cell with the same limits as an earlier
+  // cell uses the fit of that cell
+  std::vector<int> cellJob(nEt*nEta,-1);
+  std::vector<int> fitCells;
+  std::vector<TnPFitJob_t> jobs;
+  std::vector<TString> headers;
   for(int j=0; j<nEta; j++){
     for(int i=0; i<nEt; i++){
-  //for(int j=0; j<1; j++){
-    //for(int i=0; i<1; i++){
       if (targetSpecificBin==1)  {
 	if ((targetEt>=0) && (targetEt!=i)) continue;
 	if ((targetEta>=0) && (targetEta!=j)) continue;
       }
-
-      TString etCut = TString::Format(" ( et >=%6.1f && et <%6.1f ) ",
-				      limitsEt[i], limitsEt[i+1]);
-      TString etaCutFormat= DYTools::signedEtaBinning(etaBinning) ?
-	" ( eta >= %5.3f && eta < %5.3f ) " :
-	" ( abs(eta) >= %5.3f && abs(eta) < %5.3f ) ";
-
-      double limitsEtaMin = limitsEta[j];
-      double limitsEtaMax = limitsEta[j+1];	  
-      // For RECO efficiency, to increase fit stability, MERGE barrel
-      // eta bins, and separately endcap eta bins, for the binning ETABINS5,
-      // and Et < 20. 
-      //
-      // In the way it is implemented now, there is duplication of work.
-      // For example, when the eta bins 0.0-0.8 and 0.8-1.4442 are merged,
-      // we do the full fitting of the data in 0.0-1.4442 twice,
-      // once for j=0, and then again for j=1. The result of this will be identical
-      // and some CPU will be wasted. However, the bookkeeping this way is much
-      // easier, and the code is easier to read. This can be changed in the 
-      // future if needed.
-      //   Since the binning is not changed, the entries in the efficiency array
-      // will be exactly the same for the merged bins. 
-      //   The calculation of the error on the event-level scale factors as 
-      // a function of mass takes into account this 100% correlation in
-      // the efficiencies of the merged bins. This is done in calcEventEff.C
-      if( isRECO && etaBinning == DYTools::ETABINS5 && limitsEt[i+1] <= 20.0){
-	if ( j == 0 || j == 1 ){
-	  // Barrel eta bins
-	  limitsEtaMin = limitsEta[0];
-	  limitsEtaMax = limitsEta[2];
-	  printf("MERGE two barrel eta bins j=0 j=1 into one. The efficiency measurement\n");
-	  printf("      is done twice with identical data, this is the instance j=%d for Et bin i=%d\n", j,i);
-	} else if ( j ==3 || j ==4 ) {
-	  // Endcap eta bins
-	  limitsEtaMin = limitsEta[3];
-	  limitsEtaMax = limitsEta[5];
-	  printf("MERGE two endcap eta bins j=3 j=4 into one. The efficiency measurement\n");
-	  printf("      is done twice with identical data, this is the instance j=%d for Et bin i=%d\n", j,i);
-	} else {
-	  // Anything else (really, the rapidity gap, j==2)
-	  // No need to set anything, set above in declaration/initialization
+      const int idx= i + j*nEt;
+      for (unsigned int k=0; k<fitCells.size(); ++k) {
+	if (cells[idx].sameLimits(cells[fitCells[k]])) {
+	  cellJob[idx]=k;
+	  printf("bin (Et,eta)=(%d,%d) uses the fit of bin (%d,%d)\n",
+		 i,j, jobs[k].i,jobs[k].j);
+	  break;
 	}
       }
+      if (cellJob[idx]!=-1) continue;
 
-      TString etaCut = TString::Format( etaCutFormat,
-					limitsEtaMin, limitsEtaMax);
-      TString cut = etCut + TString(" && ") + etaCut;
-      //cout << cut.Data() << endl;
-      double probesPass = passTree->GetEntries(cut);
-      double probesFail = failTree->GetEntries(cut);
+      TnPFitJob_t job;
+      job.i=i; job.j=j;
       // padIdx = 1 + 2*(i + j*nEt)
-      int padIdx= 1 + ( (2*i + 2*j*nEt) % (2*DYTools::maxTnPCanvasDivisions) );
-      TPad *passPad = (TPad*)canvas->GetPad(padIdx);
-      TPad *failPad = (TPad*)canvas->GetPad(padIdx + 1);
-      double efficiency, efficiencyErrHi, efficiencyErrLo;
-      printf("\n ==\n");
-      char strOut[200];
-      sprintf(strOut,
-	   " ==   Start fitting Et: %3.0f - %3.0f  and eta:  %5.3f - %5.3f \n",
-	     limitsEt[i], limitsEt[i+1],
-	     limitsEta[j], limitsEta[j+1]);
-      printf("%s",strOut);
-      printf(" ==\n\n");
-      fitLog << endl << strOut << endl;
-      
-      if(!useTemplates){
-	fitMass(passTree, failTree, cut, method, 
-		efficiency,efficiencyErrHi, efficiencyErrLo, passPad, failPad, 
-		resultPlotsFile,
-		fitLog, NsetBins, isRECO, setBinsType, dirTag);
-      }
-      else{
-	printf("\nMASS TEMPLATES ARE USED IN THE FIT\n\n");
-	// In case templates are used, find the right templates
-	TH1F *templatePass = 
-	  getPassTemplate(i,j,etaBinning, templatesFile, puBin);
-	TH1F *templateFail = 
-	  getFailTemplate(i,j,etaBinning, templatesFile, puBin);
-
-	// In case if MERGE of the eta bins is needed for RECO efficiency (see above
-	// more detailed comments about this, we add the templates of the appropriate
-	// bins.
-	// Note: the original templates are cloned, so that we do not mess with 
-	// the original ones. This is important because each template is used twice
-	// in this implementation, once for each of the bins being merged.
+      job.padIdx= 1 + ( (2*i + 2*j*nEt) % (2*DYTools::maxTnPCanvasDivisions) );
+      job.cut=cuts[idx];
+      job.passSlice=NULL; job.failSlice=NULL;
+      job.templatePass=NULL; job.templateFail=NULL;
+      job.tmpFileBase=TString::Format("%s/tnpFit_%d_%d",gSystem->TempDirectory(),
+				      gSystem->GetPid(),int(jobs.size()));
+      job.status=0;
+
+      if (useTemplates) {
+	// In case templates are used, find the right templates.
+	// In case if MERGE of the eta bins is needed for RECO efficiency,
+	// we add the templates of the appropriate bins.
+	// Note: the templates are cloned and detached from the file
+	// before the fits start, because the forked processes may not
+	// read the file
+	int jFirst=j, jSecond=-1;
 	if( isRECO && etaBinning == DYTools::ETABINS5 && limitsEt[i+1] <= 20.0 ){
-	  if ( j == 0 || j == 1 ){
-	    // Barrel eta bins
-	    TH1F *templatePassOne = (TH1F*)getPassTemplate(i,0,etaBinning, templatesFile, puBin)->Clone();
-	    TH1F *templatePassTwo = (TH1F*)getPassTemplate(i,1,etaBinning, templatesFile, puBin)->Clone();
-	    templatePassOne->Add(templatePassTwo);
-	    templatePass = templatePassOne;
-	    TH1F *templateFailOne = (TH1F*)getFailTemplate(i,0,etaBinning, templatesFile, puBin)->Clone();
-	    TH1F *templateFailTwo = (TH1F*)getFailTemplate(i,1,etaBinning, templatesFile, puBin)->Clone();
-	    templateFailOne->Add(templateFailTwo);
-	    templateFail = templateFailOne;
-	    printf("MERGE templates for two barrel eta bins j=0 j=1 into one. The efficiency measurement\n");
-	    printf("      is done twice with identical data and templates, this is the instance j=%d for Et bin i=%d\n", j,i);
-	  } else if ( j ==3 || j ==4 ) {
-	    // Endcap eta bins
-	    TH1F *templatePassOne = (TH1F*)getPassTemplate(i,3,etaBinning, templatesFile, puBin)->Clone();
-	    TH1F *templatePassTwo = (TH1F*)getPassTemplate(i,4,etaBinning, templatesFile, puBin)->Clone();
-	    templatePassOne->Add(templatePassTwo);
-	    templatePass = templatePassOne;
-	    TH1F *templateFailOne = (TH1F*)getFailTemplate(i,3,etaBinning, templatesFile, puBin)->Clone();
-	    TH1F *templateFailTwo = (TH1F*)getFailTemplate(i,4,etaBinning, templatesFile, puBin)->Clone();
-	    templateFailOne->Add(templateFailTwo);
-	    templateFail = templateFailOne;
-	    limitsEtaMin = limitsEta[3];
-	    limitsEtaMax = limitsEta[5];
-	    printf("MERGE templates for two endcap eta bins j=3 j=4 into one. The efficiency measurement\n");
-	    printf("      is done twice with identical data and templates, this is the instance j=%d for Et bin i=%d\n", j,i);
-	  } else {
-	    // Anything else (really, the rapidity gap, j==2)
-	    // No need to set anything, set above in declaration/initialization
+	  if ( j == 0 || j == 1 ) { jFirst=0; jSecond=1; }
+	  else if ( j == 3 || j == 4 ) { jFirst=3; jSecond=4; }
+	}
+	for (int pass=1; pass>=0; --pass) {
+	  TH1F *h= (pass) ?
+	    getPassTemplate(i,jFirst,etaBinning, templatesFile, puBin) :
+	    getFailTemplate(i,jFirst,etaBinning, templatesFile, puBin);
+	  TH1F *templ= (h) ? (TH1F*)h->Clone() : NULL;
+	  if (templ) templ->SetDirectory(0);
+	  if (templ && (jSecond!=-1)) {
+	    TH1F *h2= (pass) ?
+	      getPassTemplate(i,jSecond,etaBinning, templatesFile, puBin) :
+	      getFailTemplate(i,jSecond,etaBinning, templatesFile, puBin);
+	    templ->Add(h2);
+	    printf("MERGE templates for eta bins j=%d j=%d into one for Et bin i=%d\n",jFirst,jSecond,i);
 	  }
+	  if (pass) job.templatePass=templ; else job.templateFail=templ;
 	}
+      }
 
-	if (0) {
-	  TCanvas *cx=new TCanvas("cx","cx",600,600);
-	  templatePass->SetLineColor(kGreen);
-	  templatePass->DrawCopy("hist");
-	  templateFail->SetLineColor(kRed);
-	  templateFail->DrawCopy("hist same");
-	  cx->Update();
-	  double xx; std::cin>>xx;
-	}
-      
-	fitMassWithTemplates(passTree, failTree, cut, method, 
-			     efficiency, efficiencyErrHi, efficiencyErrLo,
-			     passPad, failPad, resultPlotsFile,
-			     fitLog, templatePass, templateFail, 
-			     isRECO, setBinsType, dirTag, picFileExtraTag);
-	//std::cout << "after fitMassWithTemplates: enter a value\n"; double x; std::cin >> x;
+      cellJob[idx]=jobs.size();
+      fitCells.push_back(idx);
+      jobs.push_back(job);
+      headers.push_back(tnpFitHeader_local(etBinning,etaBinning,i,j));
+    }
+  }
+
+  // Slice the trees: one pass over each tree, or the slices of the
+  // probe store
+  {
+    std::vector<TTree*> passSlices, failSlices;
+    if (store) {
+      if (!store->matches(etBinning,etaBinning)) {
+	std::cout << "measureEfficiencyWithFit: the probe store has a different binning\n";
+	assert(0);
+      }
+      int puFirst, puLast;
+      storePURange_local(*store,puBin,puFirst,puLast);
+      sliceTnPStore_local(*store, 1, puFirst, puLast, cells, fitCells, passSlices, "passTreeBin");
+      sliceTnPStore_local(*store, 0, puFirst, puLast, cells, fitCells, failSlices, "failTreeBin");
+    }
+    else {
+      sliceTnPTree_local(passTree, absEta, cells, fitCells, passSlices, "passTreeBin");
+      sliceTnPTree_local(failTree, absEta, cells, fitCells, failSlices, "failTreeBin");
+    }
+    for (unsigned int k=0; k<jobs.size(); ++k) {
+      jobs[k].passSlice=passSlices[k];
+      jobs[k].failSlice=failSlices[k];
+    }
+  }
+
+  // Fit
+  TnPFitSettings_t settings;
+  settings.method=method;
+  settings.NsetBins=NsetBins;
+  settings.isRECO=isRECO;
+  settings.useTemplates=useTemplates;
+  settings.setBinsType=setBinsType;
+  settings.dirTag=dirTag;
+  settings.picFileExtraTag=picFileExtraTag;
+  runTnPFitJobs_local(jobs, settings, headers, canvas, nParallelFits);
+
+  // Collect the results in the bin order
+  for(int j=0; j<nEta; j++){
+    for(int i=0; i<nEt; i++){
+      const int idx= i + j*nEt;
+      if (cellJob[idx]==-1) continue;  // bin was not targeted
+      const TnPFitJob_t &job= jobs[cellJob[idx]];
+
+      double probesPass = job.passSlice->GetEntries();
+      double probesFail = job.failSlice->GetEntries();
+      // padIdx = 1 + 2*(i + j*nEt)
+      int padIdx= 1 + ( (2*i + 2*j*nEt) % (2*DYTools::maxTnPCanvasDivisions) );
+      double efficiency, efficiencyErrHi, efficiencyErrLo;
+      fitLog << endl << tnpFitHeader_local(etBinning,etaBinning,i,j) << endl;
+      collectTnPFitJob_local(job, padIdx, canvas, resultPlotsFile, fitLog,
+			     efficiency, efficiencyErrHi, efficiencyErrLo);
+      if (useTemplates) {
+	canvas->Update();
 	char buf[50];
 	sprintf(buf,"tmp_eta%d_et%d.png",j,i);
 	canvas->SaveAs(buf);
- 
       }
-            
 
+      char strOut[200];
       sprintf(strOut, "   %3.0f - %3.0f   %5.3f - %5.3f   %5.1f +%5.1f -%5.1f    %10.0f  %10.0f\n",
 	      limitsEt[i], limitsEt[i+1],
 	      limitsEta[j], limitsEta[j+1],
@@ -769,6 +1363,16 @@ void measureEfficiencyWithFit(TTree *passTree, TTree *failTree,
     }
   }
 
+  // Clean-up
+  for (unsigned int k=0; k<jobs.size(); ++k) {
+    gSystem->Unlink(jobs[k].tmpFileBase + TString(".root"));
+    gSystem->Unlink(jobs[k].tmpFileBase + TString(".log"));
+    delete jobs[k].passSlice;
+    delete jobs[k].failSlice;
+    if (jobs[k].templatePass) delete jobs[k].templatePass;
+    if (jobs[k].templateFail) delete jobs[k].templateFail;
+  }
+
   effOutput << endl;
 
   if(resultsRootFile && resultsRootFile->IsOpen()){
@@ -155,12 +155,23 @@ void printCorrelations(ostream& os, RooFitResult *res)
 }
 
 
+// ----------------------------------------------------
+
+RooDataSet* newTnPDataSet(const char *name, TTree *tree, 
+			  const RooArgSet &vars, const RooFormulaVar &rooCut,
+			  bool applyCut, const char *wgtVarName) {
+  if (applyCut) return new RooDataSet(name,name,tree,vars,rooCut,wgtVarName);
+  return new RooDataSet(name,name,tree,vars,(const char*)0,wgtVarName);
+}
+
+// ----------------------------------------------------
+
 void fitMass(TTree *passTree, TTree *failTree, TString cut, int mode, 
 	     double &efficiency, double &efficiencyErrHi, 
 	     double &efficiencyErrLo, 
 	     TPad *passPad, TPad *failPad, TFile *plotsRootFile, 
 	     ofstream &fitLog, int NsetBins, bool isRECO, 
-	     const char* setBinsType, TString dirTag){
+	     const char* setBinsType, TString dirTag, bool applyCut){
 
   // meaningless check, saving from compiler complaints
   if (dirTag.Length() && 0) 
@@ -279,20 +290,20 @@ void fitMass(TTree *passTree, TTree *failTree, TString cut, int mode,
   RooDataSet  *dataUnbinnedPass = NULL;
   RooDataSet  *dataUnbinnedFail = NULL;
   RooDataSet *dataUnbinnedPassUnweighted= (!debugWeightedFit) ? NULL :
-    new RooDataSet("dataUnbinnedPass","dataUnbinnedPass",
-		   passTree,dsetArgs, rooCut);
+    newTnPDataSet("dataUnbinnedPass",
+		   passTree,dsetArgs,rooCut,applyCut);
   RooDataSet *dataUnbinnedFailUnweighted= (!debugWeightedFit) ? NULL :
-    new RooDataSet("dataUnbinnedFail","dataUnbinnedFail",
-		   failTree,dsetArgs, rooCut);
+    newTnPDataSet("dataUnbinnedFail",
+		   failTree,dsetArgs,rooCut,applyCut);
   std::string dline(70,'-'); dline+='\n';
 
   if (!performWeightedFit) {
     dataUnbinnedPass = 
-      new RooDataSet("dataUnbinnedPass","dataUnbinnedPass",
-		     passTree,dsetArgs, rooCut);
+      newTnPDataSet("dataUnbinnedPass",
+		     passTree,dsetArgs,rooCut,applyCut);
     dataUnbinnedFail = 
-      new RooDataSet("dataUnbinnedFail","dataUnbinnedFail",
-		     failTree,dsetArgs, rooCut);
+      newTnPDataSet("dataUnbinnedFail",
+		     failTree,dsetArgs,rooCut,applyCut);
     std::cout << "\n\n\tunweighted Fit" << std::endl;
   }
   else {
@@ -300,11 +311,11 @@ void fitMass(TTree *passTree, TTree *failTree, TString cut, int mode,
     fitLog << "\n\n\tweighted Fit\n\n";
     dsetArgs.add(weight);
     dataUnbinnedPass = 
-      new RooDataSet("dataUnbinnedPass","dataUnbinnedPass",
-		     passTree,dsetArgs, rooCut, "weight");
+      newTnPDataSet("dataUnbinnedPass",
+		     passTree,dsetArgs,rooCut,applyCut, "weight");
     dataUnbinnedFail = 
-      new RooDataSet("dataUnbinnedFail","dataUnbinnedFail",
-		     failTree,dsetArgs, rooCut, "weight");
+      newTnPDataSet("dataUnbinnedFail",
+		     failTree,dsetArgs,rooCut,applyCut, "weight");
 
     std::cout << dline; dataUnbinnedPass->Print("V"); std::cout << dline;
     std::cout << dline; dataUnbinnedFail->Print("V"); std::cout << dline;
@@ -587,7 +598,7 @@ void fitMassWithTemplates(TTree *passTree, TTree *failTree, TString cut,
 			  ofstream &fitLog, 
 			  TH1F *templatePass, TH1F *templateFail, bool isRECO,
 			  const char* setBinsType, TString dirTag, 
-			  const TString &picFileExtraTag){
+			  const TString &picFileExtraTag, bool applyCut){
 
     
   const int nLims = 34;
@@ -728,19 +739,19 @@ void fitMassWithTemplates(TTree *passTree, TTree *failTree, TString cut,
   std::string dline(70,'-'); dline+='\n';
 
   RooDataSet *dataUnbinnedPassNoWeight = (!debugWeightedFit) ? NULL :
-    new RooDataSet("dataUnbinnedPassNoWeight","dataUnbinnedPassNoWeight",
-		   passTree,dsetArgs, rooCut);
+    newTnPDataSet("dataUnbinnedPassNoWeight",
+		   passTree,dsetArgs,rooCut,applyCut);
   RooDataSet *dataUnbinnedFailNoWeight = (!debugWeightedFit) ? NULL :
-    new RooDataSet("dataUnbinnedFailNoWeight","dataUnbinnedFailNoWeight",
-		   failTree,dsetArgs, rooCut);
+    newTnPDataSet("dataUnbinnedFailNoWeight",
+		   failTree,dsetArgs,rooCut,applyCut);
  
   if (!performWeightedFit) {
     dataUnbinnedPass = 
-      new RooDataSet("dataUnbinnedPass","dataUnbinnedPass",
-		     passTree,dsetArgs, rooCut);
+      newTnPDataSet("dataUnbinnedPass",
+		     passTree,dsetArgs,rooCut,applyCut);
     dataUnbinnedFail = 
-      new RooDataSet("dataUnbinnedFail","dataUnbinnedFail",
-		     failTree,dsetArgs, rooCut);
+      newTnPDataSet("dataUnbinnedFail",
+		     failTree,dsetArgs,rooCut,applyCut);
     std::cout << "\n\n\tunweighted Fit (" << dataUnbinnedPass->numEntries() 
 	      << "p," << dataUnbinnedFail->numEntries() << "f)\n\n";
   }
@@ -749,11 +760,11 @@ void fitMassWithTemplates(TTree *passTree, TTree *failTree, TString cut,
     fitLog << "\n\n\tweighted Fit\n\n";
     dsetArgs.add(weight);
     dataUnbinnedPass = 
-      new RooDataSet("dataUnbinnedPass","dataUnbinnedPass",
-		     passTree,dsetArgs, rooCut, "weight");
+      newTnPDataSet("dataUnbinnedPass",
+		     passTree,dsetArgs,rooCut,applyCut, "weight");
     dataUnbinnedFail = 
-      new RooDataSet("dataUnbinnedFail","dataUnbinnedFail",
-		     failTree,dsetArgs, rooCut, "weight");
+      newTnPDataSet("dataUnbinnedFail",
+		     failTree,dsetArgs,rooCut,applyCut, "weight");
 
     std::cout << dline; dataUnbinnedPass->Print("V"); std::cout << dline;
     std::cout << dline; dataUnbinnedFail->Print("V"); std::cout << dline;
@@ -28,6 +28,13 @@ fi
 
 collectEvents=0  # it is recommended to have collectEvents=1 in evaluateESF!
 
+# pseudo-experiments for the scale factor errors in calcEventEff
+esfToys=100
+esfToyThreads=4
+
+# bins fitted in parallel (forked processes) in the tag-and-probe fits
+tnpFitJobs=4
+
 # if you do not want to have the time stamp, comment the line away 
 # or set timeStamp=
 timeStamp="-`date +%Y%m%d-%H%M`"
@@ -158,7 +165,7 @@ runCalcEff() {
  dataKind=${inpFile/data/}
  if [ ${#dataKind} -eq ${#inpFile} ] ; then dataKind="mc"; else dataKind="data"; fi
 # calculate
- root -l -q -b  ${LXPLUS_CORRECTION} calcEff.C+\(\"${inpFile}\",\"${effKind}\",\"${triggerSet}\",${puReweight},${puDependence}\) \
+ root -l -q -b  ${LXPLUS_CORRECTION} calcEff.C+\(\"${inpFile}\",\"${effKind}\",\"${triggerSet}\",${puReweight},${puDependence},${tnpFitJobs}\) \
      | tee log${timeStamp}-calcEff-${dataKind}-${effKind}-puW${puReweight}.out
   if [ $? != 0 ] ; then noError=0;
   else 
@@ -175,7 +182,7 @@ runCalcEventEff() {
  _collectEvents=$1
  echo "_collectEvents=${_collectEvents}"
  if [ ${#_collectEvents} -eq 0 ] ; then _collectEvents=1; fi
- root -l -b -q ${LXPLUS_CORRECTION} calcEventEff.C+\(\"${mcConfInputFile}\",\"${tnpDataFile}\",\"${tnpMCFile}\",\"${triggerSet}\",${_collectEvents},${puReweight},${debugMode}\) \
+ root -l -b -q ${LXPLUS_CORRECTION} calcEventEff.C+\(\"${mcConfInputFile}\",\"${tnpDataFile}\",\"${tnpMCFile}\",\"${triggerSet}\",${_collectEvents},${puReweight},${debugMode},${esfToys},${esfToyThreads}\) \
      | tee log${timeStamp}-calcEventEff-puW${puReweight}.out
   if [ $? != 0 ] ; then noError=0;
   else 
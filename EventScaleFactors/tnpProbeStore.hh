@@ -0,0 +1,395 @@
+#ifndef tnpProbeStore_HH
+#define tnpProbeStore_HH
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TString.h>
+#include <TVectorD.h>
+#include <vector>
+#include <iostream>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/stat.h>
+
+#include "../Include/DYTools.hh"
+
+// ------------------------------------------------------
+//
+// Binned store of the tag-and-probe probes.
+//
+// eff_IdHlt.C and eff_Reco.C save the selected probes in passTree and
+// failTree. The efficiency measurements select the probes of each
+// (Et,eta) bin, and of each PU bin, from these trees. The store keeps
+// the same probes grouped contiguously by (pass/fail, Et bin, eta bin,
+// PU bin), in this order, with an offset table. The probes of a bin are
+// then a slice [groupBegin,groupEnd) of the arrays. Since the eta and
+// the PU bins are the inner indices, the slices of the merged eta bins
+// and of all PU bins of an (Et,eta) bin are contiguous as well.
+//
+// The probes are assigned to the bins using the limits rounded as in
+// the cut strings of fitFunctions.cc ("%6.1f" for Et, "%5.3f" for eta),
+// thus a bin contains exactly the probes selected by the cut. The last
+// PU bin (nPVBinCount) collects the probes with nGoodPV outside the
+// nPVLimits. The probes outside the (Et,eta) binning are not stored,
+// only counted.
+//
+// The store keeps the entry counts of passTree and failTree, and the
+// size and the modification time of the selectEvents file. A store
+// that does not match its selectEvents file is rejected, and calcEff.C
+// rebuilds it from the trees.
+//
+// File layout (<selectEvents file>_probeStore.root):
+//   TVectorD probeStoreInfo   : version, etBinning, etaBinning, nEt, nEta, nPU,
+//                               passEntries, failEntries, sourceSize, sourceModTime
+//   TVectorD probeStoreOffsets: nGroups+1 offsets
+//   TVectorD probeStoreOutside: outside-binning counts [pass*nPU + pu]
+//   TTree probeStore          : mass, et, eta, nGoodPV, weight, in the group order
+//
+// ------------------------------------------------------
+
+class tnpProbeStore_t {
+public:
+  typedef enum { _version=2, _infoSize=10 } TConst_t;
+protected:
+  int FEtBinning, FEtaBinning;
+  int FNEt, FNEta, FNPU;
+  Long64_t FPassEntries, FFailEntries; // entries of the source trees
+  Long64_t FSourceSize, FSourceModTime; // the selectEvents file
+  std::vector<double> FEtLimits, FEtaLimits; // rounded
+  std::vector<Long64_t> FOffsets;
+  std::vector<Long64_t> FOutside;
+  std::vector<Double_t> FMass, FEt, FEta, FWeight;
+  std::vector<UInt_t> FNGoodPV;
+
+public:
+  tnpProbeStore_t() : FEtBinning(-1), FEtaBinning(-1), FNEt(0), FNEta(0), FNPU(0),
+		      FPassEntries(0), FFailEntries(0), FSourceSize(0), FSourceModTime(0),
+		      FEtLimits(), FEtaLimits(), FOffsets(), FOutside(),
+		      FMass(), FEt(), FEta(), FWeight(), FNGoodPV() {}
+
+  static TString fileName(const TString &selectEventsFName) {
+    TString fname=selectEventsFName;
+    if (fname.EndsWith(".root")) fname.Remove(fname.Length()-5);
+    fname.Append("_probeStore.root");
+    return fname;
+  }
+
+  // size and modification time of a file. Returns 0 if it does not exist
+  static int fileStamp(const TString &fname, Long64_t &size, Long64_t &modTime) {
+    struct stat st;
+    if (stat(fname.Data(),&st)!=0) {
+      size=0; modTime=0;
+      return 0;
+    }
+    size=st.st_size;
+    modTime=st.st_mtime;
+    return 1;
+  }
+
+  // the limit as it appears in the cut string
+  static double roundedLimit(const char *format, double x) {
+    return atof(TString::Format(format,x).Data());
+  }
+
+  int isValid() const { return (FOffsets.size()) ? 1:0; }
+  int etBinning() const { return FEtBinning; }
+  int etaBinning() const { return FEtaBinning; }
+  int nEtBins() const { return FNEt; }
+  int nEtaBins() const { return FNEta; }
+  int nPUBins() const { return FNPU; } // incl. the out-of-range PU bin
+  Long64_t size() const { return Long64_t(FMass.size()); }
+
+  int matches(int etBinning, int etaBinning) const {
+    return (isValid() && (FEtBinning==etBinning) && (FEtaBinning==etaBinning)) ? 1:0;
+  }
+
+  // whether the store was made from these trees of the selectEvents file
+  int matchesSource(const TString &selectEventsFName, const TTree *passTree, const TTree *failTree) const {
+    if (!isValid() || !passTree || !failTree) return 0;
+    if ((FPassEntries!=passTree->GetEntries()) ||
+	(FFailEntries!=failTree->GetEntries())) return 0;
+    Long64_t size=0, modTime=0;
+    if (!fileStamp(selectEventsFName,size,modTime)) return 0;
+    return ((FSourceSize==size) && (FSourceModTime==modTime)) ? 1:0;
+  }
+
+  int groupIdx(int pass, int etBin, int etaBin, int puBin) const {
+    return ((pass*FNEt + etBin)*FNEta + etaBin)*FNPU + puBin;
+  }
+  Long64_t groupBegin(int pass, int etBin, int etaBin, int puBin) const {
+    return FOffsets[groupIdx(pass,etBin,etaBin,puBin)];
+  }
+  Long64_t groupEnd(int pass, int etBin, int etaBin, int puBin) const {
+    return FOffsets[groupIdx(pass,etBin,etaBin,puBin)+1];
+  }
+  // the probes of the PU bin (all Et,eta bins) that are not stored
+  Long64_t outsideCount(int pass, int puBin) const {
+    return FOutside[pass*FNPU + puBin];
+  }
+
+  const Double_t& mass(Long64_t i) const { return FMass[i]; }
+  const Double_t& et(Long64_t i) const { return FEt[i]; }
+  const Double_t& eta(Long64_t i) const { return FEta[i]; } // as saved
+  const Double_t& weight(Long64_t i) const { return FWeight[i]; }
+  const UInt_t& nGoodPV(Long64_t i) const { return FNGoodPV[i]; }
+
+  // ------------
+
+  void clear() {
+    FEtBinning=-1; FEtaBinning=-1; FNEt=0; FNEta=0; FNPU=0;
+    FPassEntries=0; FFailEntries=0; FSourceSize=0; FSourceModTime=0;
+    FEtLimits.clear(); FEtaLimits.clear();
+    FOffsets.clear(); FOutside.clear();
+    FMass.clear(); FEt.clear(); FEta.clear(); FWeight.clear(); FNGoodPV.clear();
+  }
+
+  // ------------
+
+  // Note: the branch addresses of the trees are reset
+  int build(TTree *passTree, TTree *failTree, int etBinning, int etaBinning) {
+    clear();
+    if (!passTree || !failTree) {
+      std::cout << "tnpProbeStore_t::build: null tree\n";
+      return 0;
+    }
+    setBinning(etBinning,etaBinning);
+    const int nGroups=2*FNEt*FNEta*FNPU;
+
+    // 1. read the probes and find their groups
+    std::vector<Double_t> mass, et, eta, weight;
+    std::vector<UInt_t> nPV;
+    std::vector<int> group;
+    std::vector<Long64_t> counts(nGroups,0);
+    for (int pass=0; pass<2; ++pass) {
+      TTree *tree=(pass) ? passTree : failTree;
+      Double_t vMass=0, vEt=0, vEta=0, vWeight=1.;
+      UInt_t vNPV=0;
+      TBranch *br[5] = { tree->GetBranch("mass"), tree->GetBranch("et"),
+			 tree->GetBranch("eta"), tree->GetBranch("nGoodPV"),
+			 tree->GetBranch("weight") };
+      if (!br[0] || !br[1] || !br[2] || !br[3]) {
+	std::cout << "tnpProbeStore_t::build: the tree <" << tree->GetName() << "> lacks branches\n";
+	clear();
+	return 0;
+      }
+      br[0]->SetAddress(&vMass);
+      br[1]->SetAddress(&vEt);
+      br[2]->SetAddress(&vEta);
+      br[3]->SetAddress(&vNPV);
+      if (br[4]) br[4]->SetAddress(&vWeight);
+      const Long64_t nEntries=tree->GetEntries();
+      if (pass) FPassEntries=nEntries; else FFailEntries=nEntries;
+      mass.reserve(mass.size()+nEntries);
+      et.reserve(et.size()+nEntries);
+      eta.reserve(eta.size()+nEntries);
+      weight.reserve(weight.size()+nEntries);
+      nPV.reserve(nPV.size()+nEntries);
+      group.reserve(group.size()+nEntries);
+      for (Long64_t i=0; i<nEntries; ++i) {
+	for (int k=0; k<5; ++k) if (br[k]) br[k]->GetEntry(i);
+	const int idx=findGroup(pass,vEt,vEta,vNPV);
+	if (idx<0) {
+	  FOutside[pass*FNPU + findStorePUBin(vNPV)]++;
+	  continue;
+	}
+	mass.push_back(vMass); et.push_back(vEt); eta.push_back(vEta);
+	weight.push_back(vWeight); nPV.push_back(vNPV);
+	group.push_back(idx);
+	counts[idx]++;
+      }
+      tree->ResetBranchAddresses();
+    }
+
+    // 2. offsets and the grouped arrays
+    FOffsets.assign(nGroups+1,0);
+    for (int i=0; i<nGroups; ++i) FOffsets[i+1]=FOffsets[i]+counts[i];
+    const Long64_t n=Long64_t(group.size());
+    FMass.resize(n); FEt.resize(n); FEta.resize(n); FWeight.resize(n); FNGoodPV.resize(n);
+    std::vector<Long64_t> pos(FOffsets.begin(),FOffsets.end()-1);
+    for (Long64_t i=0; i<n; ++i) {
+      const Long64_t k=pos[group[i]]++;
+      FMass[k]=mass[i]; FEt[k]=et[i]; FEta[k]=eta[i];
+      FWeight[k]=weight[i]; FNGoodPV[k]=nPV[i];
+    }
+    return 1;
+  }
+
+  // ------------
+
+  // selectEventsFName is the file of the trees. It has to be closed
+  // or opened read-only
+  int save(const TString &fname, const TString &selectEventsFName) {
+    if (!isValid()) {
+      std::cout << "tnpProbeStore_t::save: the store is empty\n";
+      return 0;
+    }
+    if (!fileStamp(selectEventsFName,FSourceSize,FSourceModTime)) {
+      std::cout << "tnpProbeStore_t::save: the file <" << selectEventsFName << "> does not exist\n";
+      return 0;
+    }
+    TFile fout(fname,"recreate");
+    if (!fout.IsOpen()) {
+      std::cout << "tnpProbeStore_t::save: failed to create <" << fname << ">\n";
+      return 0;
+    }
+    TVectorD info(_infoSize);
+    info[0]=_version; info[1]=FEtBinning; info[2]=FEtaBinning;
+    info[3]=FNEt; info[4]=FNEta; info[5]=FNPU;
+    info[6]=double(FPassEntries); info[7]=double(FFailEntries);
+    info[8]=double(FSourceSize); info[9]=double(FSourceModTime);
+    TVectorD offsets(FOffsets.size());
+    for (unsigned int i=0; i<FOffsets.size(); ++i) offsets[i]=double(FOffsets[i]);
+    TVectorD outside(FOutside.size());
+    for (unsigned int i=0; i<FOutside.size(); ++i) outside[i]=double(FOutside[i]);
+
+    Double_t vMass, vEt, vEta, vWeight;
+    UInt_t vNPV;
+    TTree *tree=new TTree("probeStore","probeStore");
+    tree->Branch("mass",&vMass,"mass/D");
+    tree->Branch("et",&vEt,"et/D");
+    tree->Branch("eta",&vEta,"eta/D");
+    tree->Branch("nGoodPV",&vNPV,"nGoodPV/i");
+    tree->Branch("weight",&vWeight,"weight/D");
+    for (Long64_t i=0; i<size(); ++i) {
+      vMass=FMass[i]; vEt=FEt[i]; vEta=FEta[i]; vWeight=FWeight[i]; vNPV=FNGoodPV[i];
+      tree->Fill();
+    }
+    fout.cd();
+    info.Write("probeStoreInfo");
+    offsets.Write("probeStoreOffsets");
+    outside.Write("probeStoreOutside");
+    tree->Write();
+    fout.Close();
+    std::cout << "probe store <" << fname << "> with " << size() << " probes saved\n";
+    return 1;
+  }
+
+  // ------------
+
+  // returns 1 on success, 0 if the file is missing or has a different format
+  int load(const TString &fname) {
+    clear();
+    TFile fin(fname,"read");
+    if (!fin.IsOpen()) return 0;
+    TVectorD *info=(TVectorD*)fin.Get("probeStoreInfo");
+    TVectorD *offsets=(TVectorD*)fin.Get("probeStoreOffsets");
+    TVectorD *outside=(TVectorD*)fin.Get("probeStoreOutside");
+    TTree *tree=(TTree*)fin.Get("probeStore");
+    int ok=(info && offsets && outside && tree && (info->GetNoElements()==_infoSize) &&
+	    (int((*info)[0])==_version)) ? 1:0;
+    if (ok) {
+      setBinning(int((*info)[1]),int((*info)[2]));
+      FPassEntries=Long64_t((*info)[6]+0.5);
+      FFailEntries=Long64_t((*info)[7]+0.5);
+      FSourceSize=Long64_t((*info)[8]+0.5);
+      FSourceModTime=Long64_t((*info)[9]+0.5);
+      ok=((FNEt==int((*info)[3])) && (FNEta==int((*info)[4])) &&
+	  (FNPU==int((*info)[5])) &&
+	  (offsets->GetNoElements()==2*FNEt*FNEta*FNPU+1) &&
+	  (outside->GetNoElements()==2*FNPU)) ? 1:0;
+    }
+    if (ok) {
+      FOffsets.resize(offsets->GetNoElements());
+      for (unsigned int i=0; i<FOffsets.size(); ++i) FOffsets[i]=Long64_t((*offsets)[i]+0.5);
+      for (unsigned int i=0; i<FOutside.size(); ++i) FOutside[i]=Long64_t((*outside)[i]+0.5);
+      ok=(FOffsets.back()==tree->GetEntries()) ? 1:0;
+    }
+    if (ok) {
+      const Long64_t n=tree->GetEntries();
+      FMass.resize(n); FEt.resize(n); FEta.resize(n); FWeight.resize(n); FNGoodPV.resize(n);
+      Double_t vMass, vEt, vEta, vWeight;
+      UInt_t vNPV;
+      tree->SetBranchAddress("mass",&vMass);
+      tree->SetBranchAddress("et",&vEt);
+      tree->SetBranchAddress("eta",&vEta);
+      tree->SetBranchAddress("nGoodPV",&vNPV);
+      tree->SetBranchAddress("weight",&vWeight);
+      for (Long64_t i=0; i<n; ++i) {
+	tree->GetEntry(i);
+	FMass[i]=vMass; FEt[i]=vEt; FEta[i]=vEta; FWeight[i]=vWeight; FNGoodPV[i]=vNPV;
+      }
+      tree->ResetBranchAddresses();
+    }
+    if (info) delete info;
+    if (offsets) delete offsets;
+    if (outside) delete outside;
+    fin.Close();
+    if (!ok) {
+      std::cout << "tnpProbeStore_t::load: file <" << fname << "> has unexpected format\n";
+      clear();
+    }
+    return ok;
+  }
+
+  // ------------
+
+  // In-memory tree (branches mass, et, eta, weight) with the probes of
+  // the Et bin, the eta bins etaFirst..etaLast and the PU bins
+  // puFirst..puLast
+  TTree* makeTree(const TString &name, int pass, int etBin,
+		  int etaFirst, int etaLast, int puFirst, int puLast) const {
+    Double_t vMass, vEt, vEta, vWeight;
+    TTree *tree=new TTree(name,name);
+    tree->SetDirectory(0);
+    tree->Branch("mass",&vMass,"mass/D");
+    tree->Branch("et",&vEt,"et/D");
+    tree->Branch("eta",&vEta,"eta/D");
+    tree->Branch("weight",&vWeight,"weight/D");
+    for (int j=etaFirst; j<=etaLast; ++j) {
+      const Long64_t iEnd=groupEnd(pass,etBin,j,puLast);
+      for (Long64_t i=groupBegin(pass,etBin,j,puFirst); i<iEnd; ++i) {
+	vMass=FMass[i]; vEt=FEt[i]; vEta=FEta[i]; vWeight=FWeight[i];
+	tree->Fill();
+      }
+    }
+    return tree;
+  }
+
+  // ------------
+
+protected:
+  void setBinning(int etBinning, int etaBinning) {
+    FEtBinning=etBinning;
+    FEtaBinning=etaBinning;
+    FNEt=DYTools::getNEtBins(etBinning);
+    FNEta=DYTools::getNEtaBins(etaBinning);
+    FNPU=DYTools::nPVBinCount+1;
+    const double *limitsEt=DYTools::_getEtBinLimitsPtr(etBinning);
+    const double *limitsEta=DYTools::_getEtaBinLimitsPtr(etaBinning);
+    FEtLimits.resize(FNEt+1);
+    for (int i=0; i<=FNEt; ++i) FEtLimits[i]=roundedLimit("%6.1f",limitsEt[i]);
+    FEtaLimits.resize(FNEta+1);
+    for (int i=0; i<=FNEta; ++i) FEtaLimits[i]=roundedLimit("%5.3f",limitsEta[i]);
+    FOutside.assign(2*FNPU,0);
+  }
+
+  static int findRoundedBin(double x, const std::vector<double> &limits) {
+    if ((x<limits.front()) || !(x<limits.back())) return -1;
+    int lo=0, hi=int(limits.size())-1;
+    while (hi-lo>1) {
+      const int mid=(lo+hi)/2;
+      if (x<limits[mid]) hi=mid; else lo=mid;
+    }
+    return lo;
+  }
+
+  int findStorePUBin(UInt_t nPV) const {
+    const int puBin=DYTools::findPUBin(nPV);
+    return (puBin<0) ? FNPU-1 : puBin;
+  }
+
+  int findGroup(int pass, double et, double eta, UInt_t nPV) const {
+    const int etBin=findRoundedBin(et,FEtLimits);
+    if (etBin<0) return -1;
+    if (!DYTools::signedEtaBinning(FEtaBinning)) eta=fabs(eta);
+    const int etaBin=findRoundedBin(eta,FEtaLimits);
+    if (etaBin<0) return -1;
+    return groupIdx(pass,etBin,etaBin,findStorePUBin(nPV));
+  }
+};
+
+// ------------------------------------------------------
+
+#endif
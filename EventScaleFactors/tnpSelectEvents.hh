@@ -86,6 +86,9 @@ public:
   Double_t et_1,eta_1,et_2,eta_2;
   Double_t weight;
   UInt_t nGoodPV;
+  // (et,eta) bin indices of the electrons for the scale factor tables
+  // (EsfTable_t), filled by setEsfIndices. Not saved
+  Int_t esfIdx_1, esfIdx_2; //!
 
   void assign(double _genMass, double _genY,
 	      double _mass, double _y1, 
@@ -129,6 +132,23 @@ public:
     return ((mass>=mass_low) && (mass<=mass_high));
   }
 
+  // index = etBin*nEtaBins + etaBin. The electrons outside of the 
+  // binning get the index nEtBins*nEtaBins
+  static Int_t esfIndex(double et, double eta, int etBinning, int etaBinning) {
+    const int nEtaBins=DYTools::getNEtaBins(etaBinning);
+    const int etBin=DYTools::findEtBin(et,etBinning);
+    const int etaBin=DYTools::findEtaBin(eta,etaBinning);
+    if ((etBin==-1) || (etaBin==-1)) {
+      return DYTools::getNEtBins(etBinning)*nEtaBins;
+    }
+    return etBin*nEtaBins + etaBin;
+  }
+
+  void setEsfIndices(int etBinning, int etaBinning) {
+    esfIdx_1=esfIndex(et_1,eta_1,etBinning,etaBinning);
+    esfIdx_2=esfIndex(et_2,eta_2,etBinning,etaBinning);
+  }
+
 #ifdef esfSelectEventsIsObject
   ClassDef(esfSelectEvent_t,1)
 #endif
@@ -76,6 +76,15 @@ do_efficiencyScaleFactors=1
 
 do_escaleSystematics=1  # very long calculation!
 
+# read the signal MC once for unfolding, unfoldingFsr, acceptance,
+# efficiency and the FSR corrections (FullChain/processSignalMC.C).
+# Set to 0 to run the macros one by one
+signalMC_singlePass=1
+
+# number of threads for selectEvents.C. The output does not
+# depend on the number of threads
+selection_nThreads=8
+
 
 # Determine whether it is 1D or 2D case
 chkDYTools=`grep study2D=0 ../Include/DYTools.hh`
@@ -237,13 +246,13 @@ root -b -q -l rootlogon.C+             # | tee ${logDir}/out${timeStamp}-00-incl
 if [ ${do_selection} -eq 1 ] && [ ${noError} -eq 1 ] ; then
 statusSelection=OK
 echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
-echo "WILL DO: selectEvents(\"${filename_data}\",\"${triggerSet}\",NORMAL,debug=${debugMode})"
+echo "WILL DO: selectEvents(\"${filename_data}\",\"${triggerSet}\",NORMAL,debug=${debugMode},nThreads=${selection_nThreads})"
 echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 cd ../Selection
 rm -f *.so ${expectSelectedEventsFile} ${expectSelectedEventsFile2}
 echo
 checkFile selectEvents.C
-root -b -q -l ${LXPLUS_CORRECTION} selectEvents.C+\(\"$filename_data\",\"$triggerSet\",DYTools::NORMAL,${debugMode}\)           | tee ${logDir}/out${timeStamp}-01-selectEvents${anTag}.log
+root -b -q -l ${LXPLUS_CORRECTION} selectEvents.C+\(\"$filename_data\",\"$triggerSet\",DYTools::NORMAL,${debugMode},${selection_nThreads}\)           | tee ${logDir}/out${timeStamp}-01-selectEvents${anTag}.log
 get_status ${expectSelectedEventsFile} ${expectSelectedEventsFile2}
 statusSelection=$RUN_STATUS
 cd ../FullChain
@@ -297,6 +306,30 @@ else
 fi
 
 
+#Signal MC steps in a single pass
+signalMC_done=0
+signalMC_steps="${do_unfolding}${do_unfoldingFsr}${do_acceptance}${do_efficiency}${do_plotFSRCorrections}${do_plotFSRCorrectionsSansAcc}"
+if [ ${signalMC_singlePass} -eq 1 ] && [ "${signalMC_steps}" != "000000" ] && [ ${noError} -eq 1 ] ; then
+echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
+echo "WILL DO: processSignalMC(\"${filename_mc}\",\"${triggerSet}\",steps=\"${signalMC_steps}\",debug=${debugMode})"
+echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
+for __dir in ../Unfolding ../Acceptance ../Efficiency ../Fsr ; do
+  rm -f ${__dir}/*.so
+done
+if [ ${do_unfolding} -eq 1 ] ; then rm -f ${expectUnfoldingFile}; fi
+if [ ${do_unfoldingFsr} -eq 1 ] ; then rm -f ${expectUnfoldingFileFsr}; fi
+if [ ${do_efficiency} -eq 1 ] ; then rm -f ${expectEfficiencyFile}; fi
+if [ ${do_plotFSRCorrections} -eq 1 ] ; then rm -f ${expectFsrSansAcc0File}; fi
+if [ ${do_plotFSRCorrectionsSansAcc} -eq 1 ] ; then rm -f ${expectFsrSansAcc1File}; fi
+echo
+checkFile processSignalMC.C
+root -b -q -l ${LXPLUS_CORRECTION} processSignalMC.C\(\"$filename_mc\",\"${triggerSet}\",\"${signalMC_steps}\",${fsrPUReweight},${debugMode}\)    | tee ${logDir}/out${timeStamp}-04-processSignalMC${anTag}.log
+signalMC_done=1
+echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
+echo "DONE: processSignalMC(\"${filename_mc}\",\"${triggerSet}\")"
+echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
+fi
+
 #Unfolding
 if [ ${do_unfolding} -eq 1 ] && [ ${noError} -eq 1 ] ; then
 statusUnfolding=OK
@@ -304,10 +337,12 @@ echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 echo "WILL DO: makeUnfoldingMatrix(\"${filename_mc}\",\"${triggerSet}\",debug=${debugMode})"
 echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 cd ../Unfolding
+if [ ${signalMC_done} -eq 0 ] ; then
 rm -f *.so ${expectUnfoldingFile}
 echo
 checkFile makeUnfoldingMatrix.C
 root -b -q -l ${LXPLUS_CORRECTION} makeUnfoldingMatrix.C+\(\"$filename_mc\",\"${triggerSet}\",DYTools::NORMAL,1,1.0,-1.0,${debugMode}\)    | tee ${logDir}/out${timeStamp}-04-makeUnfoldingMatrix${anTag}.log
+fi
 get_status ${expectUnfoldingFile}
 statusUnfolding=$RUN_STATUS
 cd ../FullChain
@@ -325,10 +360,12 @@ echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 echo "WILL DO: makeUnfoldingMatrixFsr(\"${filename_mc}\",\"${triggerSet}\",debug=${debugMode})"
 echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 cd ../Unfolding
+if [ ${signalMC_done} -eq 0 ] ; then
 rm -f *.so ${expectUnfoldingFileFsr}
 echo
 checkFile makeUnfoldingMatrixFsr.C
 root -b -q -l ${LXPLUS_CORRECTION} makeUnfoldingMatrixFsr.C+\(\"$filename_mc\",\"${triggerSet}\",DYTools::NORMAL,1,1.0,-1.0,${fsrPUReweight},${debugMode}\)    | tee ${logDir}/out${timeStamp}-04-makeUnfoldingMatrixFsr${anTag}.log
+fi
 get_status ${expectUnfoldingFileFsr}
 statusUnfoldingFsr=$RUN_STATUS
 cd ../FullChain
@@ -367,12 +404,14 @@ echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 echo "WILL DO: plotDYAcceptance(\"${filename_mc}\",DYTools::NORMAL,1.,-1,debug=${debugMode}\")"
 echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 cd ../Acceptance
+if [ ${signalMC_done} -eq 0 ] ; then
 rm -f *.so
 echo
 checkFile plotDYAcceptance.C
 root -b -q -l ${LXPLUS_CORRECTION} \
       plotDYAcceptance.C+\(\"$filename_mc\",DYTools::NORMAL,1.,-1,${debugMode}\) \
     | tee ${logDir}/out${timeStamp}-06-plotDYAcceptance${anTag}.log
+fi
 get_status
 statusAcceptance=$RUN_STATUS
 cd ../FullChain
@@ -412,10 +451,12 @@ echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 echo "WILL DO: plotDYEfficiency(\"${filename_mc},\"${triggerSet}\",debug=${debug}\")"
 echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 cd ../Efficiency
+if [ ${signalMC_done} -eq 0 ] ; then
 rm -f *.so ${expectEfficiencyFile}
 echo
 checkFile plotDYEfficiency.C
 root -b -q -l ${LXPLUS_CORRECTION} plotDYEfficiency.C+\(\"$filename_mc\",\"$triggerSet\",${debugMode}\)       | tee ${logDir}/out${timeStamp}-08-plotDYEfficiency${anTag}.log
+fi
 get_status ${expectEfficiencyFile}
 statusEfficiency=$RUN_STATUS
 cd ../FullChain
@@ -434,10 +475,12 @@ echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 echo "WILL DO: plotDYFSRCorrections(\"${filename_mc},sansAcc=0,debug=${debugMode}\")"
 echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 cd ../Fsr
+if [ ${signalMC_done} -eq 0 ] ; then
 rm -f *.so ${expectFsrSansAcc0File}
 echo
 checkFile plotDYFSRCorrections.C
 root -b -q -l ${LXPLUS_CORRECTION} plotDYFSRCorrections.C+\(\"$filename_mc\",0,${debugMode}\)     | tee ${logDir}/out${timeStamp}-09-plotDYFSRCorrections${anTag}.log
+fi
 get_status ${expectFsrSansAcc0File}
 statusPlotDYFSRCorrections=$RUN_STATUS
 cd ../FullChain
@@ -455,10 +498,12 @@ echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 echo "WILL DO: plotDYFSRCorrectionsSansAcc(\"${filename_mc}\",sansAcc=1,debug=${debugMode})"
 echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
 cd ../Fsr
+if [ ${signalMC_done} -eq 0 ] ; then
 rm -f *.so ${expectFsrSansAcc1File}
 echo
 checkFile plotDYFSRCorrections.C 
 root -b -q -l ${LXPLUS_CORRECTION} plotDYFSRCorrections.C+\(\"$filename_mc\",1,${debugMode}\)     | tee ${logDir}/out${timeStamp}-10-plotDYFSRCorrections-SansAcc${anTag}.out
+fi
 get_status ${expectFsrSansAcc1File}
 statusPlotDYFSRCorrectionsSansAcc=$RUN_STATUS
 cd ../FullChain
@@ -72,6 +72,12 @@ doCalculateReferenceShape=0   # if the main sequence was already run
 seedMin=1001
 seedMax=1020
 
+# The four parts run concurrently, each in its own directories.
+# The steps within a part are serial (they share the yields directory).
+# The completed steps are recorded in dir-farm-escaleSyst and are
+# skipped if the script is restarted
+nParallelJobs=4
+
 defaultEtaDistribution="6binNegs_"
 shapeDependenceStudy="Voigtian BreitWigner"
 #shapeDependenceStudy="Voigtian"
@@ -112,6 +118,8 @@ runPath=${PWD}
 logPath=${PWD}/dir-escale-logs
 if [ ! -e ${logPath} ] ; then  mkdir ${logPath}; fi
 
+. ./jobFarm.sh
+
 err=0
 calculateUnfolding=1
 model=
@@ -376,7 +384,7 @@ if [ ${copySelectedNTuples} -gt 0 ] ; then
 fi
 
 
-if [ ${err} -eq 0 ] && [ ${doStatisticalStudy} -eq 1 ] ; then
+runStatisticalStudy() {
   tag="${dirTag}_escale_randomized"
   selectionRunMode=DYTools::ESCALE_STUDY_RND
   selEventsDir=${selEventsDirT/TMPDIR/${tag}}
@@ -389,6 +397,7 @@ if [ ${err} -eq 0 ] && [ ${doStatisticalStudy} -eq 1 ] ; then
   cloneNTuples  ${selEventsDir}
   cloneDDBkgFiles  ${yieldsDir}
   while [ ${seed} -le ${seedMax} ] && [ ${err} -eq 0 ] ; do
+    if ! farmIsDone statistical_seed${seed} ; then
     model="seed${seed}"
     plotsDirExtraTag="seed${seed}"
     prepareConfFile "Date20120802_default_RANDOMIZED${seed}"
@@ -396,11 +405,14 @@ if [ ${err} -eq 0 ] && [ ${doStatisticalStudy} -eq 1 ] ; then
     calculateUnfolding=0
     deriveUnfoldedSpectrum
     renameYields
+    if [ ${err} -eq 0 ] ; then farmMarkDone statistical_seed${seed}; fi
+    fi
     seed=$(( seed + 1 ))
   done
-fi
+  return ${err}
+}
 
-if [ ${err} -eq 0 ] && [ ${doShapeSystematics} -eq 1 ] ; then
+runShapeSystematics() {
   tag="${dirTag}_escale_shape"
   selectionRunMode=DYTools::ESCALE_STUDY
   selEventsDir=${selEventsDirT/TMPDIR/${tag}}
@@ -412,7 +424,7 @@ if [ ${err} -eq 0 ] && [ ${doShapeSystematics} -eq 1 ] ; then
   cloneNTuples  ${selEventsDir}
   cloneDDBkgFiles  ${yieldsDir}
   for shape in ${shapeDependenceStudy} ; do
-    if [ ${err} -eq 0 ] ; then
+    if [ ${err} -eq 0 ] && ! farmIsDone shape_${shape} ; then
       model=${defaultEtaDistribution}${shape}_20120802
       plotsDirExtraTag="${shape}"
       prepareConfFile "File${shape}_..\/root_files\/constants\/EScale\/testESF_${model}.inp"
@@ -421,12 +433,14 @@ if [ ${err} -eq 0 ] && [ ${doShapeSystematics} -eq 1 ] ; then
       deriveUnfoldedSpectrum
       renameYields
       renameUnfoldedConstants
+      if [ ${err} -eq 0 ] ; then farmMarkDone shape_${shape}; fi
     fi
   done
-fi
+  return ${err}
+}
 
 
- if [ ${err} -eq 0 ] && [ ${doEtaSystematics} -eq 1 ] ; then
+runEtaSystematics() {
   tag="${dirTag}_escale_eta"
   selectionRunMode=DYTools::ESCALE_STUDY
   selEventsDir=${selEventsDirT/TMPDIR/${tag}}
@@ -438,6 +452,7 @@ fi
   cloneNTuples  ${selEventsDir}
   cloneDDBkgFiles  ${yieldsDir}
   for aModel in ${etaDistrArr} ; do
+    if [ ${err} -eq 0 ] && ! farmIsDone eta_${aModel} ; then
     model=${aModel}_20120802
     prepareConfFile "FileGauss_..\/root_files\/constants\/EScale\/testESF_${model}.inp"
     plotsDirExtraTag="${model}"
@@ -446,11 +461,14 @@ fi
     deriveUnfoldedSpectrum
     renameYields
     renameUnfoldedConstants
+    if [ ${err} -eq 0 ] ; then farmMarkDone eta_${aModel}; fi
+    fi
   done
-fi
+  return ${err}
+}
 
 
-if [ ${err} -eq 0 ] && [ ${doResidualShapeSystStudy} -eq 1 ] ; then
+runResidualShapeSystStudy() {
   tag="${dirTag}"
   selectionRunMode=DYTools::ESCALE_STUDY
   ntuplesDir=${ntuplesDirT/TMPDIR/${tag}}
@@ -480,6 +498,34 @@ if [ ${err} -eq 0 ] && [ ${doResidualShapeSystStudy} -eq 1 ] ; then
     anTag=${saveAnTag}
   fi
   cd ${runPath}
+  return ${err}
+}
+
+#
+# The macros are compiled once, before the parts are started
+#
+if [ ${err} -eq 0 ] ; then
+  farmInit escaleSyst ${nParallelJobs}
+  farmCompileMacro ../Selection selectEvents.C || err=1
+  farmCompileMacro ../YieldsAndBackgrounds prepareYields.C || err=1
+  farmCompileMacro ../YieldsAndBackgrounds subtractBackground.C || err=1
+  farmCompileMacro ../Unfolding makeUnfoldingMatrix.C || err=1
+fi
+
+if [ ${err} -eq 0 ] ; then
+  if [ ${doStatisticalStudy} -eq 1 ] ; then 
+    farmSubmit statistical runStatisticalStudy
+  fi
+  if [ ${doShapeSystematics} -eq 1 ] ; then
+    farmSubmit shape runShapeSystematics
+  fi
+  if [ ${doEtaSystematics} -eq 1 ] ; then
+    farmSubmit eta runEtaSystematics
+  fi
+  if [ ${doResidualShapeSystStudy} -eq 1 ] ; then
+    farmSubmit residual runResidualShapeSystStudy
+  fi
+  farmWait || err=1
 fi
 
 
@@ -0,0 +1,106 @@
+#!/bin/bash
+#
+# Helper functions to run the independent tasks of a study as concurrent
+# background processes on the local machine. The file has to be sourced:
+#
+#   . ../FullChain/jobFarm.sh
+#   farmInit  name nJobs       - prepare the farm; the markers and the logs
+#                                are kept in dir-farm-<name>
+#   farmSubmit task command    - run the command (program or shell function)
+#                                in the background, at most nJobs at a time.
+#                                The task is skipped if it was completed in
+#                                an earlier run
+#   farmWait                   - wait for all tasks; returns 1 if any failed
+#   farmIsDone/farmMarkDone step - markers for the steps inside a task
+#   farmCompileMacro dir macro.C - compile the macro before the tasks start
+#
+# A task is complete if dir-farm-<name>/<task>.done exists. The output
+# of the task goes to dir-farm-<name>/<task>.log. To redo the calculation,
+# remove the markers (or the whole directory).
+#
+# The command has to return a non-zero code on failure. Note that
+# the macros are compiled by ACLiC: they have to be compiled before
+# the tasks are submitted, otherwise the tasks would compile them
+# concurrently.
+#
+
+farmName=
+farmDir=
+farmNJobs=1
+
+# -------------------
+
+farmInit() {
+  farmName=$1
+  farmNJobs=$2
+  if [ ${#farmNJobs} -eq 0 ] || [ ${farmNJobs} -lt 1 ] ; then farmNJobs=1; fi
+  farmDir=${PWD}/dir-farm-${farmName}
+  if [ ! -e ${farmDir} ] ; then mkdir -p ${farmDir}; fi
+  rm -f ${farmDir}/*.failed
+  echo "farm ${farmName}: ${farmNJobs} concurrent job(s), markers in ${farmDir}"
+}
+
+# -------------------
+
+farmSubmit() {
+  local task=$1
+  shift
+  if [ -e ${farmDir}/${task}.done ] ; then
+    echo "farm ${farmName}: task ${task} was completed earlier, skipping"
+    return 0
+  fi
+  while [ $(jobs -rp | wc -l) -ge ${farmNJobs} ] ; do wait -n; done
+  echo "farm ${farmName}: starting task ${task}"
+  (
+    "$@" > ${farmDir}/${task}.log 2>&1
+    if [ $? -eq 0 ] ; then
+      touch ${farmDir}/${task}.done
+      echo "farm ${farmName}: task ${task} is done"
+    else
+      touch ${farmDir}/${task}.failed
+      echo "farm ${farmName}: task ${task} failed, see ${farmDir}/${task}.log"
+    fi
+  ) &
+  return 0
+}
+
+# -------------------
+
+farmWait() {
+  wait
+  local nFailed=$(ls ${farmDir}/*.failed 2>/dev/null | wc -l)
+  if [ ${nFailed} -gt 0 ] ; then
+    echo "farm ${farmName}: ${nFailed} task(s) failed"
+    ls ${farmDir}/*.failed
+    return 1
+  fi
+  echo "farm ${farmName}: all tasks are done"
+  return 0
+}
+
+# -------------------
+# markers for the steps within a task (to resume a serial loop)
+
+farmIsDone() {
+  if [ -e ${farmDir}/$1.done ] ; then return 0; fi
+  return 1
+}
+
+farmMarkDone() {
+  touch ${farmDir}/$1.done
+}
+
+# -------------------
+# compile the macro by ACLiC: farmCompileMacro directory macro.C
+
+farmCompileMacro() {
+  local dir=$1
+  local macro=$2
+  local soFile=${dir}/${macro/.C/_C.so}
+  ( cd ${dir} && printf ".L %s+\n.q\n" ${macro} | root -b -l )
+  if [ ! -f ${soFile} ] || [ ${soFile} -ot ${dir}/${macro} ] ; then
+    echo "farmCompileMacro: failed to compile ${dir}/${macro}"
+    return 1
+  fi
+  return 0
+}
@@ -2,6 +2,7 @@
 #define DYTools_HH
 
 #include <algorithm>
+#include <vector>
 #include <iostream>
 #include <math.h>
 #include <assert.h>
@@ -211,6 +212,50 @@ namespace DYTools {
 
   };
 
+  // Bin idx finder with a uniform-grid acceleration table.
+  // Each cell of the grid knows the first bin that overlaps with it,
+  // thus only one or two limits have to be compared. The result is the
+  // same as of _findMassBin (limits have to be increasing)
+  struct BinLocator_t {
+    int fN;
+    const double *fLimits;
+    double fLo, fHi, fInvCellWidth;
+    std::vector<int> fCellBin;
+
+    BinLocator_t(int n, const double *limits) :
+      fN(n), fLimits(limits), fLo(limits[0]), fHi(limits[n]),
+      fInvCellWidth(0.), fCellBin()
+    {
+      double minWidth=fHi-fLo;
+      for (int i=0; i<n; ++i) {
+	if (limits[i+1]-limits[i] < minWidth) minWidth=limits[i+1]-limits[i];
+      }
+      int nCells=int(2*(fHi-fLo)/minWidth) + 1;
+      if (nCells<n) nCells=n;
+      if (nCells>8192) nCells=8192;
+      fInvCellWidth=nCells/(fHi-fLo);
+      fCellBin.resize(nCells);
+      int ibin=0;
+      for (int icell=0; icell<nCells; ++icell) {
+	const double cellLo=fLo + icell/fInvCellWidth;
+	while ((ibin<n-1) && (cellLo>=limits[ibin+1])) ibin++;
+	// guard against the rounding in cellLo
+	while ((ibin>0) && (cellLo<limits[ibin])) ibin--;
+	fCellBin[icell]=ibin;
+      }
+    }
+
+    int find(double x) const {
+      if (!((x>=fLo) && (x<fHi))) return -1;
+      int icell=int((x-fLo)*fInvCellWidth);
+      if (icell>=int(fCellBin.size())) icell=int(fCellBin.size())-1;
+      int ibin=fCellBin[icell];
+      while ((ibin>0) && (x<fLimits[ibin])) ibin--;
+      while (x>=fLimits[ibin+1]) ibin++;
+      return ibin;
+    }
+  };
+
   // some derived bin idx finders -- for debug
   inline int _findMassBin2012(double mass) { return _findMassBin(mass,_nMassBins2012,_massBinLimits2012); }
   inline int _findMassBin2011(double mass) { return _findMassBin(mass,_nMassBins2011,_massBinLimits2011); }
@@ -264,7 +309,11 @@ namespace DYTools {
   //
 
   // find mass bin idx
-  inline int findMassBin(double mass) { return _findMassBin(mass,nMassBins,massBinLimits); }
+  inline const BinLocator_t& massBinLocator() {
+    static const BinLocator_t locator(nMassBins,massBinLimits);
+    return locator;
+  }
+  inline int findMassBin(double mass) { return massBinLocator().find(mass); }
 
 
   template<class Idx_t>
@@ -280,7 +329,7 @@ namespace DYTools {
   int findYBin(int massBin, double y){
   
     int result = -1;
-    if( massBin < 0 || massBin > nMassBins) return result;
+    if( massBin < 0 || massBin >= nMassBins) return result;
     if ( y < yRangeMin  ||  y > yRangeMax ) return result;
 
     int nYBinsThisMassRange = nYBins[massBin];
@@ -357,6 +406,43 @@ namespace DYTools {
   }
   
 
+  // Lookup tables for the flat (mass,y) index: the flat index of the
+  // first rapidity bin of every mass slice, and the scale converting
+  // |y| to the rapidity bin index
+  struct FlatIndexLocator_t {
+    std::vector<int> fOffset;
+    std::vector<double> fYScale;
+
+    FlatIndexLocator_t() : fOffset(nMassBins+1,0), fYScale(nMassBins,0.) {
+      for (int i=0; i<nMassBins; ++i) {
+	fOffset[i+1]=fOffset[i]+nYBins[i];
+	fYScale[i]= 1.000001*nYBins[i]/(yRangeMax - yRangeMin);
+      }
+    }
+
+    // the same as findIndexFlat(mass,y), without the printout
+    int locate(double mass, double y) const {
+      const int massBin=massBinLocator().find(mass);
+      if (massBin<0) return -1;
+      const double absY=fabs(y);
+      if (!((absY>=yRangeMin) && (absY<=yRangeMax))) return -1;
+      const int yBin=int((absY-yRangeMin)*fYScale[massBin]);
+      if (yBin>=fOffset[massBin+1]-fOffset[massBin]) return -1;
+      return fOffset[massBin]+yBin;
+    }
+
+    // locate for arrays of events
+    template<class T>
+    void locate(int n, const T *mass, const T *y, int *flatIdx) const {
+      for (int i=0; i<n; ++i) flatIdx[i]=this->locate(mass[i],y[i]);
+    }
+  };
+
+  inline const FlatIndexLocator_t& flatIndexLocator() {
+    static const FlatIndexLocator_t locator;
+    return locator;
+  }
+
   // This function finds a unique 1D index for (index_m, index_y) pair
   inline 
   int findIndexFlat(int massBin, int yBin){
@@ -365,11 +451,7 @@ namespace DYTools {
     if( massBin < 0 || massBin >= nMassBins || yBin < 0 || yBin >= nYBins[massBin] )
       return result;
     
-    result = 0;
-    for(int i=0; i< massBin; i++)
-      result += nYBins[i];
-    
-    result += yBin;
+    result = flatIndexLocator().fOffset[massBin] + yBin;
     
     return result;
   }
@@ -382,6 +464,14 @@ namespace DYTools {
     return findIndexFlat(massBin,yBin);
   }
 
+  // flat (mass,|y|) index of an event (-1 if out of range),
+  // and of arrays of events
+  inline int locate(double mass, double y) { return flatIndexLocator().locate(mass,y); }
+  template<class T>
+  inline void locate(int n, const T *mass, const T *y, int *flatIdx) {
+    flatIndexLocator().locate(n,mass,y,flatIdx);
+  }
+
   // 
   // 
   // Unfolding matrix binning
@@ -509,10 +599,9 @@ namespace DYTools {
     return n;
   }
 
+  // pointer to the bin limits (no copy)
   inline 
-  double *getEtBinLimits(int binning){
-    int n = getNEtBins(binning);
-    double *limitsOut = new double[n+1];
+  const double *_getEtBinLimitsPtr(int binning){
     const double *limits = NULL;
     switch(binning) {
     case ETBINS1: limits=etBinLimits1; break;
@@ -529,6 +618,14 @@ namespace DYTools {
       printf("ERROR: unknown/undefined binning requested\n");
       assert(0);
     }
+    return limits;
+  }
+
+  inline 
+  double *getEtBinLimits(int binning){
+    int n = getNEtBins(binning);
+    double *limitsOut = new double[n+1];
+    const double *limits = _getEtBinLimitsPtr(binning);
     for(int i=0; i<=n; i++)
       limitsOut[i] = limits[i];
     
@@ -537,18 +634,7 @@ namespace DYTools {
 
   inline 
   int findEtBin(double et, int binning){
-    
-    int result =-1;
-    int n = getNEtBins(binning);
-    double *limits = getEtBinLimits(binning);
-    for(int ibin=0; ibin < n; ibin++){
-      if( et >= limits[ibin] && et < limits[ibin+1]) {
-	result = ibin;
-	break;
-      }
-    }
-    delete limits;
-    return result;
+    return _findMassBin(et,getNEtBins(binning),_getEtBinLimitsPtr(binning));
   };
 
   typedef enum {ETABINS_UNDEFINED=-1, ETABINS1=1, ETABINS2, ETABINS2Negs, ETABINS3, ETABINS3Negs, ETABINS5, ETABINS5Negs, ETABINS4test, ETABINS4testNegs,  ETABINS4alt, ETABINS4altNegs, ETABINS5alt, ETABINS5altNegs, ETABINS8alt, ETABINS8altNegs} TEtaBinSet_t;
@@ -625,10 +711,9 @@ namespace DYTools {
     return n;
   }
 
+  // pointer to the bin limits (no copy)
   inline 
-  double *getEtaBinLimits(int binning){
-    int n = getNEtaBins(binning);
-    double *limitsOut = new double[n+1];
+  const double *_getEtaBinLimitsPtr(int binning){
     const double *limits = NULL;
     switch(binning) {
     case ETABINS1: limits = etaBinLimits1; break;
@@ -648,8 +733,15 @@ namespace DYTools {
     default:
       printf("ERROR: unknown/undefined binning requested\n");
       assert(0);
-      n=0;
     }
+    return limits;
+  }
+
+  inline 
+  double *getEtaBinLimits(int binning){
+    int n = getNEtaBins(binning);
+    double *limitsOut = new double[n+1];
+    const double *limits = _getEtaBinLimitsPtr(binning);
     for (int i=0; i<=n; ++i) {
       limitsOut[i] = limits[i];
     }
@@ -687,18 +779,8 @@ namespace DYTools {
 
   inline 
   int findEtaBin(double eta, int binning){
-    int result =-1;
-    int n = getNEtaBins(binning);
-    const double *limits = getEtaBinLimits(binning);
     if (!signedEtaBinning(binning) && (eta<0)) eta=-eta;
-    for(int ibin=0; ibin < n; ibin++){
-      if( eta >= limits[ibin] && eta < limits[ibin+1]) {
-	result = ibin;
-	break;
-      }
-    }
-    delete limits;
-    return result;
+    return _findMassBin(eta,getNEtaBins(binning),_getEtaBinLimitsPtr(binning));
   }
 
 
@@ -710,7 +792,10 @@ namespace DYTools {
   const double nPVLimits[nPVBinCount+1] = { 0.5, 2.5, 4.5, 6.5, 8.5, 10.5, 12.5, 14.5, 16.5, 20.5, 24.5, 40.5 };
   //  1., 3., 5., 7., 9., 11., 13., 15., 17., 21., 25., 40. };
 
-  inline int findPUBin(int nPV) { return _findMassBin(double(nPV),nPVBinCount,nPVLimits); }
+  inline int findPUBin(int nPV) { 
+    static const BinLocator_t locator(nPVBinCount,nPVLimits);
+    return locator.find(double(nPV));
+  }
   
   // 
   // Cross section types
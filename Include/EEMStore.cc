@@ -0,0 +1,214 @@
+#include "../Include/EEMStore.hh"
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// --------------------------------------------------------------
+
+const char eemStoreMagic[8]="EEMSTOR";
+
+// --------------------------------------------------------------
+
+TString EEMStore_t::storeFileName(const TString &eemFileName) {
+  TString fname=eemFileName;
+  if (fname.EndsWith(".root")) fname.Remove(fname.Length()-5);
+  fname.Append(".eem");
+  return fname;
+}
+
+// --------------------------------------------------------------
+
+int EEMStore_t::fileStamp(const TString &fname, Long64_t &size, Long64_t &modTime) {
+  struct stat st;
+  if (stat(fname.Data(),&st)!=0) {
+    size=0; modTime=0;
+    return 0;
+  }
+  size=st.st_size;
+  modTime=st.st_mtime;
+  return 1;
+}
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
+
+int writeBlock_local(FILE *f, const void *data, ULong64_t n, UInt_t elementSize) {
+  const ULong64_t size=n*elementSize;
+  const ULong64_t padding=EEMStore_t::blockSize(n,elementSize) - size;
+  const char zeros[EEMStore_t::_alignment]={0};
+  if (size && (fwrite(data,1,size,f)!=size)) return 0;
+  if (padding && (fwrite(zeros,1,padding,f)!=padding)) return 0;
+  return 1;
+}
+
+// --------------------------------------------------------------
+
+int EEMStoreWriter_t::close() {
+  const int nEtaBins=this->etaBinCount();
+  const int nCells=EEMStore_t::cellCount(nEtaBins);
+  const ULong64_t n=this->size();
+
+  // counting sort by the cell index. The order within a cell is kept
+  std::vector<ULong64_t> offsets(nCells+1,0);
+  for (ULong64_t i=0; i<n; ++i) offsets[FCells[i]+1]++;
+  for (int i=0; i<nCells; ++i) offsets[i+1]+=offsets[i];
+  std::vector<ULong64_t> order(n);
+  {
+    std::vector<ULong64_t> pos(offsets.begin(),offsets.end()-1);
+    for (ULong64_t i=0; i<n; ++i) order[pos[FCells[i]]++]=i;
+  }
+
+  EEMStoreHeader_t h;
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,eemStoreMagic,sizeof(h.magic));
+  h.version=EEMStore_t::_version;
+  h.nEtaBins=nEtaBins;
+  h.nCells=nCells;
+  h.alignment=EEMStore_t::_alignment;
+  h.nRecords=n;
+  if (FSourceName.Length() &&
+      !EEMStore_t::fileStamp(FSourceName,h.sourceSize,h.sourceModTime)) {
+    std::cout << "EEMStoreWriter_t::close: source file <" << FSourceName << "> does not exist\n";
+    return 0;
+  }
+
+  const TString tmpName=FName + TString(".tmp");
+  FILE *f=fopen(tmpName.Data(),"wb");
+  if (!f) {
+    std::cout << "EEMStoreWriter_t::close: failed to create <" << tmpName << ">\n";
+    return 0;
+  }
+  int ok=(fwrite(&h,sizeof(h),1,f)==1) ? 1:0;
+  if (ok) ok=writeBlock_local(f,&FEtaBinLimits[0],nEtaBins+1,sizeof(Double_t));
+  if (ok) ok=writeBlock_local(f,&offsets[0],nCells+1,sizeof(ULong64_t));
+  std::vector<Double_t> buf(n);
+  for (unsigned int col=0; ok && (col<FDoubleCols.size()); ++col) {
+    const std::vector<Double_t> &src=FDoubleCols[col];
+    for (ULong64_t i=0; i<n; ++i) buf[i]=src[order[i]];
+    ok=writeBlock_local(f,(n) ? &buf[0] : NULL,n,sizeof(Double_t));
+  }
+  if (ok) {
+    std::vector<Int_t> ibuf(n);
+    for (ULong64_t i=0; i<n; ++i) ibuf[i]=FNGoodPV[order[i]];
+    ok=writeBlock_local(f,(n) ? &ibuf[0] : NULL,n,sizeof(Int_t));
+  }
+  if (fclose(f)!=0) ok=0;
+  if (ok && (rename(tmpName.Data(),FName.Data())!=0)) ok=0;
+  if (!ok) {
+    std::cout << "EEMStoreWriter_t::close: failed to write <" << FName << ">\n";
+    remove(tmpName.Data());
+    return 0;
+  }
+  std::cout << "EEM store <" << FName << "> with " << n << " records saved\n";
+  for (unsigned int col=0; col<FDoubleCols.size(); ++col) FDoubleCols[col].clear();
+  FNGoodPV.clear();
+  FCells.clear();
+  return 1;
+}
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
+
+int EEMStoreReader_t::open(const TString &fname, const TString &sourceFileName) {
+  this->close();
+  FName=fname;
+  int fd=::open(fname.Data(),O_RDONLY);
+  if (fd<0) return 0;
+  struct stat st;
+  if ((fstat(fd,&st)!=0) || (ULong64_t(st.st_size)<sizeof(EEMStoreHeader_t))) {
+    ::close(fd);
+    std::cout << "EEMStoreReader_t::open: file <" << fname << "> is too short\n";
+    return 0;
+  }
+  void *ptr=mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+  ::close(fd);
+  if (ptr==MAP_FAILED) {
+    std::cout << "EEMStoreReader_t::open: failed to map <" << fname << ">\n";
+    return 0;
+  }
+  FMap=(char*)ptr;
+  FMapSize=st.st_size;
+
+  const EEMStoreHeader_t *h=(const EEMStoreHeader_t*)FMap;
+  const ULong64_t n=h->nRecords;
+  const ULong64_t expectedSize= sizeof(EEMStoreHeader_t) +
+    EEMStore_t::blockSize(h->nEtaBins+1,sizeof(Double_t)) +
+    EEMStore_t::blockSize(ULong64_t(h->nCells)+1,sizeof(ULong64_t)) +
+    (EEMStore_t::_columnCount-1) * EEMStore_t::blockSize(n,sizeof(Double_t)) +
+    EEMStore_t::blockSize(n,sizeof(Int_t));
+  if ((memcmp(h->magic,eemStoreMagic,sizeof(h->magic))!=0) ||
+      (h->version!=EEMStore_t::_version) ||
+      (h->alignment!=EEMStore_t::_alignment) ||
+      (int(h->nCells)!=EEMStore_t::cellCount(h->nEtaBins)) ||
+      (FMapSize!=expectedSize)) {
+    std::cout << "EEMStoreReader_t::open: file <" << fname << "> has unexpected format\n";
+    this->close();
+    FName=fname;
+    return 0;
+  }
+
+  // the store is valid only for the ROOT file it was made with
+  Long64_t sourceSize=0, sourceModTime=0;
+  if (sourceFileName.Length()) {
+    if (!EEMStore_t::fileStamp(sourceFileName,sourceSize,sourceModTime)) {
+      std::cout << "EEMStoreReader_t::open: warning: source file <" << sourceFileName
+		<< "> is missing, <" << fname << "> is used unchecked\n";
+    }
+    else if ((h->sourceSize!=sourceSize) || (h->sourceModTime!=sourceModTime)) {
+      std::cout << "EEMStoreReader_t::open: file <" << fname
+		<< "> does not match <" << sourceFileName << ">\n";
+      this->close();
+      FName=fname;
+      return 0;
+    }
+  }
+
+  FNEtaBins=h->nEtaBins;
+  FNRecords=n;
+  const char *p=FMap + sizeof(EEMStoreHeader_t);
+  FEtaBinLimits=(const Double_t*)p;
+  p+=EEMStore_t::blockSize(FNEtaBins+1,sizeof(Double_t));
+  FOffsets=(const ULong64_t*)p;
+  p+=EEMStore_t::blockSize(ULong64_t(h->nCells)+1,sizeof(ULong64_t));
+  for (int i=0; i<EEMStore_t::_nGoodPV; ++i) {
+    FDoubleCols[i]=(const Double_t*)p;
+    p+=EEMStore_t::blockSize(n,sizeof(Double_t));
+  }
+  FNGoodPV=(const Int_t*)p;
+  if (FOffsets[h->nCells]!=n) {
+    std::cout << "EEMStoreReader_t::open: file <" << fname << "> has inconsistent cell offsets\n";
+    this->close();
+    FName=fname;
+    return 0;
+  }
+  return 1;
+}
+
+// --------------------------------------------------------------
+
+void EEMStoreReader_t::close() {
+  if (FMap) munmap(FMap,FMapSize);
+  FMap=NULL;
+  FMapSize=0;
+  FNEtaBins=0;
+  FNRecords=0;
+  FEtaBinLimits=NULL;
+  FOffsets=NULL;
+  for (int i=0; i<EEMStore_t::_nGoodPV; ++i) FDoubleCols[i]=NULL;
+  FNGoodPV=NULL;
+}
+
+// --------------------------------------------------------------
+
+int EEMStoreReader_t::sameBinning(int nEtaBins, const double *etaBinLimits) const {
+  if (!FMap || (nEtaBins!=FNEtaBins)) return 0;
+  for (int i=0; i<=nEtaBins; ++i) {
+    if (FEtaBinLimits[i]!=etaBinLimits[i]) return 0;
+  }
+  return 1;
+}
+
+// --------------------------------------------------------------
@@ -0,0 +1,171 @@
+#ifndef EEMStore_HH
+#define EEMStore_HH
+
+#include <TROOT.h>
+#include <TString.h>
+#include <vector>
+#include <iostream>
+#include "../Include/EtaEtaMass.hh"
+
+// Binary store of the (eta,eta,mass) records
+//
+// selectEvents.C writes, next to each *_EtaEtaM.root file, a *_EtaEtaM.eem
+// file with the same records. The records are sorted by the triangular
+// (eta1,eta2) cell index of ElectronEnergyScale::getEtaEtaIdx, and a cell
+// offset table gives the first record of each cell. The reader maps the
+// file into memory, thus the masses of a cell are a contiguous array.
+// The records outside of the eta binning are kept in an extra last cell.
+//
+// File layout:
+//   header (EEMStoreHeader_t, 64 bytes)
+//   eta bin limits, Double_t[nEtaBins+1]
+//   cell offsets, ULong64_t[nCells+1]
+//   columns in the order of TColumn_t: mass, weight, eta1, eta2 (Double_t)
+//     and nGoodPV (Int_t)
+// Every block starts at an offset that is a multiple of 64 bytes.
+// Within a cell, the records keep the order in which they were added
+//
+// The header keeps the size and the modification time of the EEM ROOT
+// file. A store that does not match its ROOT file is not used, and the
+// loaders of ElectronEnergyScale read the ROOT file instead
+
+// --------------------------------------------------------------
+
+struct EEMStoreHeader_t {
+  char magic[8];       // "EEMSTOR"
+  UInt_t version;
+  UInt_t nEtaBins;
+  UInt_t nCells;
+  UInt_t alignment;
+  ULong64_t nRecords;
+  Long64_t sourceSize;     // size and modification time of the ROOT file
+  Long64_t sourceModTime;
+  char reserved[16];
+};
+
+// --------------------------------------------------------------
+
+class EEMStore_t {
+public:
+  typedef enum { _mass=0, _weight, _eta1, _eta2, _nGoodPV,
+		 _columnCount } TColumn_t;
+  typedef enum { _version=2, _alignment=64 } TConst_t;
+
+  static TString storeFileName(const TString &eemFileName);
+  // size and modification time of a file. Returns 0 if it does not exist
+  static int fileStamp(const TString &fname, Long64_t &size, Long64_t &modTime);
+  // number of (eta1,eta2) cells, including the cell of the outside records
+  static int cellCount(int nEtaBins) { return nEtaBins*(nEtaBins+1)/2 + 1; }
+  static ULong64_t blockSize(ULong64_t n, UInt_t elementSize) {
+    ULong64_t size=n*elementSize;
+    return ((size+_alignment-1)/_alignment)*_alignment;
+  }
+};
+
+// --------------------------------------------------------------
+
+// Accumulates the records in memory and writes them on close()
+
+class EEMStoreWriter_t {
+protected:
+  TString FName, FSourceName;
+  std::vector<double> FEtaBinLimits;
+  std::vector<std::vector<Double_t> > FDoubleCols;
+  std::vector<Int_t> FNGoodPV;
+  std::vector<int> FCells;
+public:
+  // set_sourceName is the EEM ROOT file with the same records.
+  // It has to be closed before close()
+  EEMStoreWriter_t(const TString &set_fname, int nEtaBins, const double *etaBinLimits,
+		   const TString &set_sourceName="") :
+    FName(set_fname), FSourceName(set_sourceName),
+    FEtaBinLimits(etaBinLimits,etaBinLimits+nEtaBins+1),
+    FDoubleCols(EEMStore_t::_nGoodPV), FNGoodPV(), FCells()
+  {}
+
+  const TString& fileName() const { return FName; }
+  int etaBinCount() const { return int(FEtaBinLimits.size())-1; }
+  ULong64_t size() const { return FCells.size(); }
+
+  // cell is the triangular index, negative for the outside records
+  void add(const EtaEtaMassData_t &eem, int cell) {
+    FDoubleCols[EEMStore_t::_mass  ].push_back(eem.mass());
+    FDoubleCols[EEMStore_t::_weight].push_back(eem.weight());
+    FDoubleCols[EEMStore_t::_eta1  ].push_back(eem.eta1());
+    FDoubleCols[EEMStore_t::_eta2  ].push_back(eem.eta2());
+    FNGoodPV.push_back(eem.nGoodPV());
+    const int nCells=EEMStore_t::cellCount(this->etaBinCount());
+    FCells.push_back(((cell<0) || (cell>=nCells-1)) ? nCells-1 : cell);
+  }
+
+  // sorts the records and writes the file (via a temporary file,
+  // renamed when complete)
+  int close();
+};
+
+// --------------------------------------------------------------
+
+// Maps a store file into memory. The pointers are valid while the reader
+// is open
+
+class EEMStoreReader_t {
+protected:
+  TString FName;
+  char *FMap;
+  ULong64_t FMapSize;
+  int FNEtaBins;
+  ULong64_t FNRecords;
+  const Double_t *FEtaBinLimits;
+  const ULong64_t *FOffsets;
+  const Double_t *FDoubleCols[EEMStore_t::_nGoodPV];
+  const Int_t *FNGoodPV;
+public:
+  EEMStoreReader_t() :
+    FName(), FMap(NULL), FMapSize(0), FNEtaBins(0), FNRecords(0),
+    FEtaBinLimits(NULL), FOffsets(NULL), FNGoodPV(NULL)
+  {
+    for (int i=0; i<EEMStore_t::_nGoodPV; ++i) FDoubleCols[i]=NULL;
+  }
+  ~EEMStoreReader_t() { this->close(); }
+
+  // returns 1 on success, 0 if the file is missing or not valid.
+  // If sourceFileName is given, the store has to match that ROOT file.
+  // A missing source file gives a warning only
+  int open(const TString &fname, const TString &sourceFileName="");
+  void close();
+
+  int isOpen() const { return (FMap) ? 1:0; }
+  const TString& fileName() const { return FName; }
+  ULong64_t size() const { return FNRecords; }
+  int etaBinCount() const { return FNEtaBins; }
+  const Double_t* etaBinLimits() const { return FEtaBinLimits; }
+  int cellCount() const { return (FMap) ? EEMStore_t::cellCount(FNEtaBins) : 0; }
+  // whether the records were sorted with this eta binning
+  int sameBinning(int nEtaBins, const double *etaBinLimits) const;
+
+  ULong64_t cellBegin(int cell) const { return FOffsets[cell]; }
+  ULong64_t cellEnd(int cell) const { return FOffsets[cell+1]; }
+  ULong64_t cellSize(int cell) const { return FOffsets[cell+1]-FOffsets[cell]; }
+
+  // the columns are indexed by the record number. The records of
+  // a cell are in [cellBegin(cell),cellEnd(cell))
+  const Double_t* column(EEMStore_t::TColumn_t col) const { return (col<EEMStore_t::_nGoodPV) ? FDoubleCols[col] : NULL; }
+  const Double_t* mass() const { return FDoubleCols[EEMStore_t::_mass]; }
+  const Double_t* weight() const { return FDoubleCols[EEMStore_t::_weight]; }
+  const Double_t* eta1() const { return FDoubleCols[EEMStore_t::_eta1]; }
+  const Double_t* eta2() const { return FDoubleCols[EEMStore_t::_eta2]; }
+  const Int_t* nGoodPV() const { return FNGoodPV; }
+
+  // masses of a cell
+  const Double_t* cellMasses(int cell) const { return FDoubleCols[EEMStore_t::_mass] + FOffsets[cell]; }
+
+  void getRecord(ULong64_t i, EtaEtaMassData_t &eem) const {
+    eem.Assign(FDoubleCols[EEMStore_t::_eta1][i],FDoubleCols[EEMStore_t::_eta2][i],
+	       FDoubleCols[EEMStore_t::_mass][i],FDoubleCols[EEMStore_t::_weight][i],
+	       FNGoodPV[i]);
+  }
+};
+
+// --------------------------------------------------------------
+
+#endif
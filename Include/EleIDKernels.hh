@@ -0,0 +1,260 @@
+#ifndef ELEIDKERNELS_HH
+#define ELEIDKERNELS_HH
+
+#include <math.h>
+#include <vector>
+#include <TMath.h>
+#include "../Include/TElectron.hh"
+#include "../Include/TDielectron.hh"
+#include "../Include/EleIDCuts.hh"
+
+// EGM cut-based electron ID evaluated on batches of electrons
+//
+// The ID variables are collected in EleIDBatch_t, a structure of arrays
+// filled either from TElectron or from both legs of a TDielectron (no
+// temporary TElectron is created). EGMIDKernel_t<year,wp> applies the
+// cuts of passEGMID(electron,wp,rho,year). The cut values are resolved
+// at compile time from EGMIDCuts_t<wp> and EGMIDAeff_t<year>, and the
+// result is a bitmask with one bit per electron of the batch.
+// The cut values are the ones of the _EGM2011_* tables in EleIDCuts.hh
+
+// --------------------------------------------------------------
+
+template<int wp> struct EGMIDCuts_t;
+
+#define EGMID_WP_CUTS(wp, vD0, vDZ, vMissingHits, vConvVFit, vInvEMinusInvP, \
+		      vDEtaEB, vDPhiEB, vSieieEB, vHoEEB, vRelPFIsoEB,	\
+		      vDEtaEE, vDPhiEE, vSieieEE, vHoEEE, vRelPFIsoEEHighPt, vRelPFIsoEELowPt) \
+  template<> struct EGMIDCuts_t<wp> {					\
+    static Double_t d0Vtx() { return vD0; }				\
+    static Double_t dzVtx() { return vDZ; }				\
+    static Double_t missingHits() { return vMissingHits; }		\
+    static Double_t passConvVFitCut() { return vConvVFit; }		\
+    static Double_t invEMinusInvP() { return vInvEMinusInvP; }		\
+    static Double_t dEtaEB() { return vDEtaEB; }			\
+    static Double_t dPhiEB() { return vDPhiEB; }			\
+    static Double_t sigmaIetaIetaEB() { return vSieieEB; }		\
+    static Double_t hoeEB() { return vHoEEB; }				\
+    static Double_t relPFIsoEB() { return vRelPFIsoEB; }		\
+    static Double_t dEtaEE() { return vDEtaEE; }			\
+    static Double_t dPhiEE() { return vDPhiEE; }			\
+    static Double_t sigmaIetaIetaEE() { return vSieieEE; }		\
+    static Double_t hoeEE() { return vHoEEE; }				\
+    static Double_t relPFIsoEEHighPt() { return vRelPFIsoEEHighPt; }	\
+    static Double_t relPFIsoEELowPt() { return vRelPFIsoEELowPt; }	\
+  };
+
+// -1 means that the cut is not applied
+EGMID_WP_CUTS(WP_VETO,   0.04, 0.2, -1, -1, -1,
+	      0.007, 0.8,  0.01, 0.15, 0.15,
+	      0.01,  0.7,  0.03, -1,   0.15, 0.15)
+EGMID_WP_CUTS(WP_LOOSE,  0.02, 0.2,  1,  1, 0.05,
+	      0.007, 0.15, 0.01, 0.12, 0.15,
+	      0.009, 0.10, 0.03, 0.10, 0.15, 0.10)
+EGMID_WP_CUTS(WP_MEDIUM, 0.02, 0.1,  1,  1, 0.05,
+	      0.004, 0.06, 0.01, 0.12, 0.15,
+	      0.007, 0.03, 0.03, 0.10, 0.15, 0.10)
+EGMID_WP_CUTS(WP_TIGHT,  0.02, 0.1,  0,  1, 0.05,
+	      0.004, 0.03, 0.01, 0.12, 0.10,
+	      0.005, 0.02, 0.03, 0.10, 0.10, 0.07)
+
+#undef EGMID_WP_CUTS
+
+// --------------------------------------------------------------
+
+// effective area for the rho correction (dR<0.3), as a function of |scEta|
+template<int year> struct EGMIDAeff_t;
+
+template<> struct EGMIDAeff_t<EGM2011> {
+  static Double_t aeff(Double_t absEta) {
+    if (absEta<0.0) return 0.;
+    if (absEta<1.0) return 0.10;
+    if (absEta<1.479) return 0.12;
+    if (absEta<2.0) return 0.085;
+    if (absEta<2.2) return 0.11;
+    if (absEta<2.3) return 0.12;
+    if (absEta<2.4) return 0.12;
+    if (absEta<100.0) return 0.13;
+    return 0.;
+  }
+};
+
+template<> struct EGMIDAeff_t<EGM2012> {
+  static Double_t aeff(Double_t absEta) {
+    if (absEta<0.0) return 0.;
+    if (absEta<1.0) return 0.13;
+    if (absEta<1.479) return 0.14;
+    if (absEta<2.0) return 0.070;
+    if (absEta<2.2) return 0.090;
+    if (absEta<2.3) return 0.11;
+    if (absEta<2.4) return 0.11;
+    if (absEta<100.0) return 0.14;
+    return 0.;
+  }
+};
+
+// --------------------------------------------------------------
+
+class EleIDBatch_t {
+public:
+  std::vector<Float_t> pt, scEta, d0, dz, ecalE, EoverP;
+  std::vector<Float_t> chIso, gammaIso, neuHadIso; // sums over the rings up to dR=0.3
+  std::vector<Float_t> deltaEtaIn, deltaPhiIn, sigiEtaiEta, HoverE;
+  std::vector<UInt_t> nExpHitsInner;
+  std::vector<UChar_t> isConv;
+  std::vector<Double_t> rho;
+
+public:
+  EleIDBatch_t() :
+    pt(), scEta(), d0(), dz(), ecalE(), EoverP(),
+    chIso(), gammaIso(), neuHadIso(),
+    deltaEtaIn(), deltaPhiIn(), sigiEtaiEta(), HoverE(),
+    nExpHitsInner(), isConv(), rho()
+  {}
+
+  unsigned int size() const { return pt.size(); }
+
+  // the capacity is kept
+  void clear() {
+    pt.clear(); scEta.clear(); d0.clear(); dz.clear(); ecalE.clear(); EoverP.clear();
+    chIso.clear(); gammaIso.clear(); neuHadIso.clear();
+    deltaEtaIn.clear(); deltaPhiIn.clear(); sigiEtaiEta.clear(); HoverE.clear();
+    nExpHitsInner.clear(); isConv.clear(); rho.clear();
+  }
+
+  // returns the index of the electron in the batch
+  unsigned int add(const mithep::TElectron *e, double set_rho) {
+    pt.push_back(e->pt);
+    scEta.push_back(e->scEta);
+    d0.push_back(e->d0);
+    dz.push_back(e->dz);
+    ecalE.push_back(e->ecalE);
+    EoverP.push_back(e->EoverP);
+    chIso.push_back(e->chIso_00_01 + e->chIso_01_02 + e->chIso_02_03);
+    gammaIso.push_back(e->gammaIso_00_01 + e->gammaIso_01_02 + e->gammaIso_02_03);
+    neuHadIso.push_back(e->neuHadIso_00_01 + e->neuHadIso_01_02 + e->neuHadIso_02_03);
+    deltaEtaIn.push_back(e->deltaEtaIn);
+    deltaPhiIn.push_back(e->deltaPhiIn);
+    sigiEtaiEta.push_back(e->sigiEtaiEta);
+    HoverE.push_back(e->HoverE);
+    nExpHitsInner.push_back(e->nExpHitsInner);
+    isConv.push_back((e->isConv) ? 1:0);
+    rho.push_back(set_rho);
+    return pt.size()-1;
+  }
+
+  // adds both legs. Returns the index of the first leg,
+  // the second leg has the next index
+  unsigned int addLegs(const mithep::TDielectron *d, double set_rho) {
+    pt.push_back(d->pt_1);                 pt.push_back(d->pt_2);
+    scEta.push_back(d->scEta_1);           scEta.push_back(d->scEta_2);
+    d0.push_back(d->d0_1);                 d0.push_back(d->d0_2);
+    dz.push_back(d->dz_1);                 dz.push_back(d->dz_2);
+    ecalE.push_back(d->ecalE_1);           ecalE.push_back(d->ecalE_2);
+    EoverP.push_back(d->EoverP_1);         EoverP.push_back(d->EoverP_2);
+    chIso.push_back(d->chIso_00_01_1 + d->chIso_01_02_1 + d->chIso_02_03_1);
+    chIso.push_back(d->chIso_00_01_2 + d->chIso_01_02_2 + d->chIso_02_03_2);
+    gammaIso.push_back(d->gammaIso_00_01_1 + d->gammaIso_01_02_1 + d->gammaIso_02_03_1);
+    gammaIso.push_back(d->gammaIso_00_01_2 + d->gammaIso_01_02_2 + d->gammaIso_02_03_2);
+    neuHadIso.push_back(d->neuHadIso_00_01_1 + d->neuHadIso_01_02_1 + d->neuHadIso_02_03_1);
+    neuHadIso.push_back(d->neuHadIso_00_01_2 + d->neuHadIso_01_02_2 + d->neuHadIso_02_03_2);
+    deltaEtaIn.push_back(d->deltaEtaIn_1); deltaEtaIn.push_back(d->deltaEtaIn_2);
+    deltaPhiIn.push_back(d->deltaPhiIn_1); deltaPhiIn.push_back(d->deltaPhiIn_2);
+    sigiEtaiEta.push_back(d->sigiEtaiEta_1); sigiEtaiEta.push_back(d->sigiEtaiEta_2);
+    HoverE.push_back(d->HoverE_1);         HoverE.push_back(d->HoverE_2);
+    nExpHitsInner.push_back(d->nExpHitsInner_1); nExpHitsInner.push_back(d->nExpHitsInner_2);
+    isConv.push_back((d->isConv_1) ? 1:0); isConv.push_back((d->isConv_2) ? 1:0);
+    rho.push_back(set_rho);                rho.push_back(set_rho);
+    return pt.size()-2;
+  }
+
+  // bitmask access: bit (i%32) of the word i/32
+  static unsigned int wordCount(unsigned int n) { return (n+31)/32; }
+  static int testBit(const std::vector<UInt_t> &bits, unsigned int i) {
+    return (bits[i>>5] >> (i&31)) & 1;
+  }
+};
+
+// --------------------------------------------------------------
+
+template<int year, int wp>
+struct EGMIDKernel_t {
+  typedef EGMIDCuts_t<wp> Cuts_t;
+
+  static bool pass(const EleIDBatch_t &b, unsigned int i) {
+    bool ok= !(fabs(b.d0[i]) > Cuts_t::d0Vtx()) && !(fabs(b.dz[i]) > Cuts_t::dzVtx());
+
+    // conversion rejection
+    if (Cuts_t::missingHits() != -1) ok = ok && !(b.nExpHitsInner[i] > Cuts_t::missingHits());
+    if (Cuts_t::passConvVFitCut() != -1) ok = ok && !b.isConv[i];
+
+    // Cut on fabs(1/E - 1/p)
+    if (Cuts_t::invEMinusInvP() != -1) {
+      double invEMinusInvP = (1/b.ecalE[i])*fabs( 1 - b.EoverP[i] );
+      ok = ok && !(invEMinusInvP > Cuts_t::invEMinusInvP());
+    }
+
+    // PF isolation with the rho correction
+    const Float_t absEta=fabs(b.scEta[i]);
+    double gammaIso=b.gammaIso[i];
+    double neuHadIso=b.neuHadIso[i];
+    double relPFIso03 = ( b.chIso[i] + TMath::Max( gammaIso + neuHadIso - b.rho[i]*EGMIDAeff_t<year>::aeff(absEta), 0.0) )
+      / b.pt[i];
+
+    if (absEta<1.479) {
+      // barrel
+      ok = ok && !(relPFIso03 > Cuts_t::relPFIsoEB())
+	&& !(fabs(b.deltaEtaIn[i]) > Cuts_t::dEtaEB())
+	&& !(fabs(b.deltaPhiIn[i]) > Cuts_t::dPhiEB())
+	&& !(b.sigiEtaiEta[i] > Cuts_t::sigmaIetaIetaEB())
+	&& !(b.HoverE[i] > Cuts_t::hoeEB());
+    }
+    else {
+      // endcap
+      const double isoCut=(b.pt[i]>20) ? Cuts_t::relPFIsoEEHighPt() : Cuts_t::relPFIsoEELowPt();
+      ok = ok && !(relPFIso03 > isoCut)
+	&& !(fabs(b.deltaEtaIn[i]) > Cuts_t::dEtaEE())
+	&& !(fabs(b.deltaPhiIn[i]) > Cuts_t::dPhiEE())
+	&& !(b.sigiEtaiEta[i] > Cuts_t::sigmaIetaIetaEE());
+      if (Cuts_t::hoeEE() != -1) ok = ok && !(b.HoverE[i] > Cuts_t::hoeEE());
+    }
+    return ok;
+  }
+
+  // bit i of the mask is set if electron i passes
+  static void evaluate(const EleIDBatch_t &b, std::vector<UInt_t> &bits) {
+    const unsigned int n=b.size();
+    bits.assign(EleIDBatch_t::wordCount(n),0);
+    for (unsigned int i=0; i<n; ++i) {
+      if (pass(b,i)) bits[i>>5] |= (UInt_t(1) << (i&31));
+    }
+  }
+};
+
+// --------------------------------------------------------------
+
+// run-time choice of the kernel
+inline void evaluateEGMID(const EleIDBatch_t &b, EGMID_t year, WorkingPointType wp, std::vector<UInt_t> &bits) {
+  if (year==EGM2012) {
+    switch(wp) {
+    case WP_VETO:   EGMIDKernel_t<EGM2012,WP_VETO  >::evaluate(b,bits); return;
+    case WP_LOOSE:  EGMIDKernel_t<EGM2012,WP_LOOSE >::evaluate(b,bits); return;
+    case WP_MEDIUM: EGMIDKernel_t<EGM2012,WP_MEDIUM>::evaluate(b,bits); return;
+    case WP_TIGHT:  EGMIDKernel_t<EGM2012,WP_TIGHT >::evaluate(b,bits); return;
+    }
+  }
+  else {
+    switch(wp) {
+    case WP_VETO:   EGMIDKernel_t<EGM2011,WP_VETO  >::evaluate(b,bits); return;
+    case WP_LOOSE:  EGMIDKernel_t<EGM2011,WP_LOOSE >::evaluate(b,bits); return;
+    case WP_MEDIUM: EGMIDKernel_t<EGM2011,WP_MEDIUM>::evaluate(b,bits); return;
+    case WP_TIGHT:  EGMIDKernel_t<EGM2011,WP_TIGHT >::evaluate(b,bits); return;
+    }
+  }
+  printf("evaluateEGMID: unknown working point %d\n",int(wp));
+  assert(0);
+}
+
+// --------------------------------------------------------------
+
+#endif
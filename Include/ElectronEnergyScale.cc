@@ -7,6 +7,7 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <TMath.h>
 #include "MyTools.hh"
 
 #ifdef UseEEM
@@ -77,6 +78,13 @@ void ElectronEnergyScale::clear() {
     if (_mcConst3Err) delete[] _mcConst3Err;
     if (_mcConst4Err) delete[] _mcConst4Err;
   }
+  // the kernels of the previous calibration set are not valid anymore
+  for (int i=0; i<nMaxFunctions; ++i) {
+    for (int j=0; j<nMaxFunctions; ++j) {
+      smearingKernelGrid[i][j].clear();
+      smearingKernelGridRandomized[i][j].clear();
+    }
+  }
 }
 
 //------------------------------------------------------
@@ -901,6 +909,7 @@ bool ElectronEnergyScale::initializeExtraSmearingFunction(int normalize){
 	smearingFunctionGrid[i][j]->SetNpx(500);
 	double amp=(normalize) ? 1.0/(sij*sqrt(8*atan(1))) : 1.0;
 	smearingFunctionGrid[i][j]->SetParameters(amp,0.0,sij);
+	smearingKernelGrid[i][j].setGauss(sij,normalize);
       }
 	break;
       case Date20130529_2012_j22_adhoc: {
@@ -911,6 +920,7 @@ bool ElectronEnergyScale::initializeExtraSmearingFunction(int normalize){
 	double si = _mcConst1[i];
 	double amp=(normalize) ? 1.0/(si*sqrt(8*atan(1))) : 1.0;
 	smearingFunctionGrid[i][j]->SetParameters(amp,0.0,si);
+	smearingKernelGrid[i][j].setGauss(si,normalize);
       }
 	break;
       case CalSet_File_BreitWigner: {
@@ -921,6 +931,7 @@ bool ElectronEnergyScale::initializeExtraSmearingFunction(int normalize){
 	const double sj = _mcConst1[j];
 	const double sij=sqrt(si*si+sj*sj);
 	smearingFunctionGrid[i][j]->SetParameters(0.,sij);
+	smearingKernelGrid[i][j].setBreitWigner(sij);
       }
 	break;
       case CalSet_File_Voigt: {
@@ -934,6 +945,7 @@ bool ElectronEnergyScale::initializeExtraSmearingFunction(int normalize){
 	const double gammaj = _mcConst2[j];
 	const double gammaij = sqrt(gammai*gammai + gammaj*gammaj);
 	smearingFunctionGrid[i][j]->SetParameters(sij,gammaij);
+	smearingKernelGrid[i][j].setVoigt(sij,gammaij);
       }
 	break;
       default:
@@ -1174,7 +1186,11 @@ void ElectronEnergyScale::randomizeSmearingWidth(int seed){
 	double sj = _mcConst1[j] + rand.Gaus(0.0,_mcConst1Err[j]);
 	double sij= sqrt(si*si+sj*sj);
 	smearingFunctionGridRandomized[i][j]->SetParameters(1.0/(sij*sqrt(8*atan(1))),0.0,sij);
-	if (i>j) { smearingFunctionGridRandomized[i][j]->SetParameters(smearingFunctionGridRandomized[j][i]->GetParameters()); }
+	smearingKernelGridRandomized[i][j].setGauss(sij,1);
+	if (i>j) { 
+	  smearingFunctionGridRandomized[i][j]->SetParameters(smearingFunctionGridRandomized[j][i]->GetParameters());
+	  smearingKernelGridRandomized[i][j]=smearingKernelGridRandomized[j][i];
+	}
       } // end inner loop over eta bins
     } // end outer loop over eta bins
   }
@@ -1188,7 +1204,11 @@ void ElectronEnergyScale::randomizeSmearingWidth(int seed){
 	smearingFunctionGridRandomized[i][j]->SetNpx(500);
 	double si = _mcConst1[i] + rand.Gaus(0.0,_mcConst1Err[i]);
 	smearingFunctionGridRandomized[i][j]->SetParameters(1.0/(si*sqrt(8*atan(1))),0.0,si);
-	if (i>j) { smearingFunctionGridRandomized[i][j]->SetParameters(smearingFunctionGridRandomized[j][i]->GetParameters()); }
+	smearingKernelGridRandomized[i][j].setGauss(si,1);
+	if (i>j) { 
+	  smearingFunctionGridRandomized[i][j]->SetParameters(smearingFunctionGridRandomized[j][i]->GetParameters());
+	  smearingKernelGridRandomized[i][j]=smearingKernelGridRandomized[j][i];
+	}
       } // end inner loop over eta bins
     } // end outer loop over eta bins
   }
@@ -1360,15 +1380,21 @@ bool ElectronEnergyScale::addSmearedWeightAny(TH1F *hMass, int eta1Bin, int eta2
 
   eta1Bin--; eta2Bin--;
   assert((eta1Bin>=0)); assert((eta2Bin>=0));
-  TF1 *smearFnc = (randomize) ? 
-    smearingFunctionGridRandomized[eta1Bin][eta2Bin] :
-    smearingFunctionGrid[eta1Bin][eta2Bin];
+  const SmearingKernel_t &kernel= (randomize) ? 
+    smearingKernelGridRandomized[eta1Bin][eta2Bin] :
+    smearingKernelGrid[eta1Bin][eta2Bin];
+  assert(kernel.isSet());
 
+  // Bin integrals are the differences of the cumulative function
+  // at the bin edges
   TH1F *h=hMass;
+  double cdfLow=kernel.cdf(h->GetBinLowEdge(1)-mass);
   for (int i=1; i<=h->GetNbinsX(); i++) {
     const double xa=h->GetBinLowEdge(i);
     const double xw=h->GetBinWidth(i);
-    const double w= smearFnc->Integral( xa-mass, xa-mass+xw );
+    const double cdfHigh=kernel.cdf(xa-mass+xw);
+    const double w= cdfHigh - cdfLow;
+    cdfLow=cdfHigh;
     h->Fill(xa+0.5*xw, w * weight);
     //std::cout << "adding " << w *weight << " in " << (xa+0.5*xw) << "\n";
   }
@@ -1380,11 +1406,131 @@ bool ElectronEnergyScale::addSmearedWeightAny(TH1F *hMass, int eta1Bin, int eta2
 
 void ElectronEnergyScale::smearDistributionAny(TH1F *destination, int eta1Bin, int eta2Bin, const TH1F *source, bool randomize) const {
   assert(source); assert(destination);
+  if (!_isInitialized || (_calibrationSet == UNCORRECTED) ||
+      (randomize && !this->isSmearRandomized())) {
+    // let addSmearedWeightAny deal with these cases
+    for (int i=1; i<source->GetNbinsX(); ++i) {
+      assert(addSmearedWeightAny(destination,eta1Bin,eta2Bin,source->GetBinCenter(i),source->GetBinContent(i),randomize));
+    }
+    return;
+  }
+
+  eta1Bin--; eta2Bin--;
+  assert((eta1Bin>=0)); assert((eta2Bin>=0));
+  const SmearingKernel_t &kernel= (randomize) ? 
+    smearingKernelGridRandomized[eta1Bin][eta2Bin] :
+    smearingKernelGrid[eta1Bin][eta2Bin];
+  assert(kernel.isSet());
+
+  // destination bin edges and centers are prepared once
+  const int nDest=destination->GetNbinsX();
+  std::vector<double> edges(nDest+1), centers(nDest);
+  for (int j=1; j<=nDest; ++j) {
+    edges[j-1]=destination->GetBinLowEdge(j);
+    centers[j-1]=edges[j-1] + 0.5*destination->GetBinWidth(j);
+  }
+  edges[nDest]=destination->GetBinLowEdge(nDest)+destination->GetBinWidth(nDest);
+
+  // row of the smearing matrix for every source bin
+  std::vector<double> cdfs(nDest+1);
   for (int i=1; i<source->GetNbinsX(); ++i) {
-    assert(addSmearedWeightAny(destination,eta1Bin,eta2Bin,source->GetBinCenter(i),source->GetBinContent(i),randomize));
+    const double mass=source->GetBinCenter(i);
+    const double weight=source->GetBinContent(i);
+    for (int j=0; j<=nDest; ++j) cdfs[j]=kernel.cdf(edges[j]-mass);
+    for (int j=0; j<nDest; ++j) {
+      destination->Fill(centers[j], (cdfs[j+1]-cdfs[j]) * weight);
+    }
   }
 }
 
+//------------------------------------------------------
+//------------------------------------------------------
+
+void SmearingKernel_t::setGauss(double set_sigma, int normalized) {
+  this->clear();
+  kind=_gauss;
+  sigma=set_sigma;
+  norm=(normalized) ? 1. : sigma*sqrt(8*atan(1));
+}
+
+//------------------------------------------------------
+
+void SmearingKernel_t::setBreitWigner(double set_gamma) {
+  this->clear();
+  kind=_breitWigner;
+  gamma=set_gamma;
+  norm=1.;
+}
+
+//------------------------------------------------------
+
+void SmearingKernel_t::setVoigt(double set_sigma, double set_gamma) {
+  if (set_gamma<=0) { this->setGauss(set_sigma,1); return; }
+  if (set_sigma<=0) { this->setBreitWigner(set_gamma); return; }
+  this->clear();
+  kind=_voigt;
+  sigma=set_sigma;
+  gamma=set_gamma;
+  norm=1.;
+
+  // Voigt - BreitWigner falls as 1/x^4, tabulate it within
+  // +/-(10+10 sigma) and integrate with Simpson's rule
+  const double halfWidth= 10. + 10.*sigma;
+  const int nSteps=2000;
+  tabMin=-halfWidth;
+  tabStep=2*halfWidth/nSteps;
+  tabCdf.resize(nSteps+1);
+  tabPdf.resize(nSteps+1);
+  const double pi=4*atan(1);
+  for (int i=0; i<=nSteps; ++i) {
+    const double x=tabMin + i*tabStep;
+    tabPdf[i]= TMath::Voigt(x,sigma,gamma) - 0.5*gamma/pi/(x*x+0.25*gamma*gamma);
+  }
+  tabCdf[0]=0.;
+  for (int i=1; i<=nSteps; ++i) {
+    const double xm=tabMin + (i-0.5)*tabStep;
+    const double pdfMid= TMath::Voigt(xm,sigma,gamma) - 0.5*gamma/pi/(xm*xm+0.25*gamma*gamma);
+    tabCdf[i]=tabCdf[i-1] + tabStep/6.*(tabPdf[i-1] + 4*pdfMid + tabPdf[i]);
+  }
+  // the difference of the cumulative functions vanishes at both ends
+  const double offset=tabCdf[nSteps];
+  for (int i=0; i<=nSteps; ++i) tabCdf[i] -= offset * i/double(nSteps);
+}
+
+//------------------------------------------------------
+
+double SmearingKernel_t::cdf(double x) const {
+  double res=0;
+  switch(kind) {
+  case _gauss:
+    if (sigma>0) res= 0.5*norm*(1+TMath::Erf(x/(sigma*sqrt(2.))));
+    else res= (x>=0) ? norm : 0.;
+    break;
+  case _breitWigner:
+    if (gamma>0) res= 0.5 + atan(2*x/gamma)/(4*atan(1));
+    else res= (x>=0) ? 1. : 0.;
+    break;
+  case _voigt: {
+    res= 0.5 + atan(2*x/gamma)/(4*atan(1));
+    const double u=(x-tabMin)/tabStep;
+    const int n=int(tabCdf.size())-1;
+    if ((u>0) && (u<n)) {
+      // cubic Hermite interpolation of the tabulated difference
+      const int i=int(u);
+      const double t=u-i;
+      const double t2=t*t, t3=t2*t;
+      res += (2*t3-3*t2+1)*tabCdf[i] + (t3-2*t2+t)*tabStep*tabPdf[i]
+	+ (-2*t3+3*t2)*tabCdf[i+1] + (t3-t2)*tabStep*tabPdf[i+1];
+    }
+  }
+    break;
+  default:
+    std::cout << "SmearingKernel_t::cdf: the kernel is not set\n";
+    assert(0);
+  }
+  return res;
+}
+
 //------------------------------------------------------
 
 void ElectronEnergyScale::print() const {
@@ -1698,8 +1844,67 @@ TString ElectronEnergyScale::calibrationSetShortName() const {
 
 //------------------------------------------------------
 
+#ifdef UseEEM
+inline void addEEMRecord_local(const EEMStoreReader_t &store, ULong64_t i, std::vector<double> &dest) {
+  dest.push_back(store.mass()[i]);
+}
+
+inline void addEEMRecord_local(const EEMStoreReader_t &store, ULong64_t i, std::vector<EtaEtaMassData_t> &dest) {
+  dest.push_back(EtaEtaMassData_t());
+  store.getRecord(i,dest.back());
+}
+
+// Distributes the records of the binary store into the (eta1,eta2) cells.
+// If the store was sorted with the same eta binning, the cells are taken
+// as they are
+
+template<class T>
+void fillEEMCells_local(const ElectronEnergyScale &es, const EEMStoreReader_t &store, double massMin, double massMax, std::vector<std::vector<T>*> &eemData) {
+  const int nCells=es.numberOfEtaBins()*(es.numberOfEtaBins()+1)/2;
+  eemData.clear(); eemData.reserve(nCells+1);
+  const Double_t *mass=store.mass();
+  if (store.sameBinning(es.numberOfEtaBins(),es.etaBinLimits())) {
+    for (int k=0; k<nCells; ++k) {
+      std::vector<T>* tmp=new std::vector<T>();
+      tmp->reserve(store.cellSize(k));
+      for (ULong64_t i=store.cellBegin(k); i<store.cellEnd(k); ++i) {
+	if ((mass[i]<massMin) || (mass[i]>massMax)) continue;
+	addEEMRecord_local(store,i,*tmp);
+      }
+      eemData.push_back(tmp);
+    }
+    return;
+  }
+  // different binning
+  std::vector<int> cellIdx(store.size(),-1);
+  std::vector<int> counts(nCells,0);
+  for (ULong64_t i=0; i<store.size(); ++i) {
+    if ((mass[i]<massMin) || (mass[i]>massMax)) continue;
+    const int idx=es.getEtaEtaIdx(store.eta1()[i],store.eta2()[i]);
+    if ((idx>=0) && (idx<nCells)) { cellIdx[i]=idx; counts[idx]++; }
+  }
+  for (int k=0; k<nCells; ++k) {
+    std::vector<T>* tmp=new std::vector<T>();
+    tmp->reserve(counts[k]);
+    eemData.push_back(tmp);
+  }
+  for (ULong64_t i=0; i<store.size(); ++i) {
+    if (cellIdx[i]>=0) addEEMRecord_local(store,i,*eemData[cellIdx[i]]);
+  }
+}
+#endif
+
+//------------------------------------------------------
+
 #ifdef UseEEM
 int ElectronEnergyScale::loadEEMFile(const TString &eemFileName, vector<vector<double>*> &eemData) const {
+  {
+    EEMStoreReader_t store;
+    if (store.open(EEMStore_t::storeFileName(eemFileName),eemFileName)) {
+      fillEEMCells_local(*this,store,-1e9,1e9,eemData);
+      return 1;
+    }
+  }
   EtaEtaMassData_t *eem = new EtaEtaMassData_t();
   int res=1;
   int etaEtaCount = this->numberOfEtaEtaBins();
@@ -1761,6 +1966,13 @@ int ElectronEnergyScale::loadEEMFile(const TString &eemFileName, vector<vector<d
 #ifdef UseEEM
 int ElectronEnergyScale::loadEEMFile(const TString &eemFileName, vector<vector<double>*> &eemData, double massMin, double massMax) const {
   ClearVec(eemData);
+  {
+    EEMStoreReader_t store;
+    if (store.open(EEMStore_t::storeFileName(eemFileName),eemFileName)) {
+      fillEEMCells_local(*this,store,massMin,massMax,eemData);
+      return 1;
+    }
+  }
   std::vector<std::vector<EtaEtaMassData_t>*> data;
   int res=this->loadEEMFile(eemFileName,data,massMin,massMax);
   if (!res) {
@@ -1786,6 +1998,13 @@ int ElectronEnergyScale::loadEEMFile(const TString &eemFileName, vector<vector<d
 
 #ifdef UseEEM
 int ElectronEnergyScale::loadEEMFile(const TString &eemFileName, vector<vector<EtaEtaMassData_t>*> &eemData, double massMin, double massMax) const {
+  {
+    EEMStoreReader_t store;
+    if (store.open(EEMStore_t::storeFileName(eemFileName),eemFileName)) {
+      fillEEMCells_local(*this,store,massMin,massMax,eemData);
+      return 1;
+    }
+  }
   EtaEtaMassData_t *eem = new EtaEtaMassData_t();
   int res=1;
   int etaEtaCount = this->numberOfEtaEtaBins();
@@ -10,8 +10,45 @@
 
 #ifdef UseEEM
 #include "../Include/EtaEtaMass.hh"
+#include "../Include/EEMStore.hh"
 #endif
 
+#include <vector>
+
+// Smearing function of an (eta1,eta2) cell, as needed for the
+// distribution smearing (addSmearedWeight, smearDistribution).
+// The integral over a mass bin is the difference of two values of
+// the cumulative function: closed form for Gauss and Breit-Wigner.
+// For Voigt, the difference to the Breit-Wigner cumulative function
+// is tabulated when the kernel is set up.
+
+struct SmearingKernel_t {
+  typedef enum { _none=0, _gauss, _breitWigner, _voigt } TKernelType_t;
+
+  TKernelType_t kind;
+  double norm;    // integral over (-inf,inf)
+  double sigma, gamma;
+  double tabMin, tabStep;
+  std::vector<double> tabCdf, tabPdf;  // Voigt-BreitWigner at the nodes
+
+  SmearingKernel_t() : kind(_none), norm(0.), sigma(0.), gamma(0.),
+    tabMin(0.), tabStep(0.), tabCdf(), tabPdf() {}
+
+  bool isSet() const { return (kind!=_none) ? true : false; }
+  void clear() { kind=_none; norm=0.; sigma=0.; gamma=0.; tabCdf.clear(); tabPdf.clear(); }
+
+  // normalized=0 corresponds to the gaus(0) function with amplitude 1
+  void setGauss(double set_sigma, int normalized);
+  void setBreitWigner(double set_gamma);
+  void setVoigt(double set_sigma, double set_gamma);
+
+  // integral from -inf to x
+  double cdf(double x) const;
+  double integral(double xmin, double xmax) const { return cdf(xmax)-cdf(xmin); }
+};
+
+// --------------------------------------------------------
+
 class ElectronEnergyScale {
 
 public:
@@ -62,6 +99,7 @@ public:
   bool setCalibrationSet(CalibrationSet calSet); // in specific cases allow to change the calibration set
   int numberOfEtaBins() const { return _nEtaBins; }
   int numberOfEtaEtaBins() const { return _nEtaBins*(_nEtaBins+1); }
+  const double* etaBinLimits() const { return _etaBinLimits; }
 
   // Eta bin index in the same way as TH1F bin index
   int getEtaBinIdx(double eta) const {
@@ -143,6 +181,8 @@ public:
   TH1F* createSmearHisto(const TString &namebase, int parameterNo) const;
 
 #ifdef UseEEM
+  // The loaders use the binary store (EEMStore.hh) next to the EEM file,
+  // if it is available and matches the EEM file
   int loadEEMFile(const TString &eemFileName, vector<vector<double>*> &eemData) const;
   int loadEEMFile(const TString &eemFileName, vector<vector<double>*> &eemData, double massMin, double massMax) const;
   int loadEEMFile(const TString &eemFileName, vector<vector<EtaEtaMassData_t>*> &eemData, double massMin=-1e9, double massMax=1e9) const;
@@ -219,6 +259,9 @@ protected:
   static const int nMaxFunctions = 50;
   TF1 *smearingFunctionGrid[nMaxFunctions][nMaxFunctions];
   TF1 *smearingFunctionGridRandomized[nMaxFunctions][nMaxFunctions];
+  // the same functions, for the bin integrals
+  SmearingKernel_t smearingKernelGrid[nMaxFunctions][nMaxFunctions];
+  SmearingKernel_t smearingKernelGridRandomized[nMaxFunctions][nMaxFunctions];
 
 };
 
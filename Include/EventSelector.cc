@@ -151,4 +151,15 @@ std::ostream& DielectronSelector_t::printCounts(std::ostream &out) {
 
 // ---------------------------------------------------------------
 
+void DielectronSelector_t::addCounts(const DielectronSelector_t &sel) {
+  fTotalCandidates += sel.fTotalCandidates;
+  fCandidatesGoodEta += sel.fCandidatesGoodEta;
+  fCandidatesGoodEt += sel.fCandidatesGoodEt;
+  fCandidatesHLTMatched += sel.fCandidatesHLTMatched;
+  fCandidatesIDPassed += sel.fCandidatesIDPassed;
+  fCandidatesMassAboveMinLimit += sel.fCandidatesMassAboveMinLimit;
+}
+
+// ---------------------------------------------------------------
+
 // ---------------------------------------------------------------
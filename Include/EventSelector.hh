@@ -67,6 +67,8 @@ public:
   }
 
   std::ostream& printCounts(std::ostream&);
+  // add the candidate counts of another selector (e.g. of a worker thread)
+  void addCounts(const DielectronSelector_t &sel);
 };
 
 // -------------------------------------------------
@@ -3,6 +3,8 @@
 
 #include "DYTools.hh"
 #include <TH2D.h>
+#include <vector>
+#include <algorithm>
 
 //  Definition of a FEWZ_t class which knows the internal structure
 //  of FEWZ correction file and provides the correction factor for 
@@ -12,6 +14,10 @@
 // 2) weights used for 8 TeV analysis are provided as a macro from Alexey. 
 // This class interfaces the macro. The definitions need adaptation in case
 // the macro is changed
+//
+// The 7 TeV histograms are copied at load time into one contiguous table
+// of (weight,error) pairs ordered by (mass,pt,y). The 8 TeV maps are
+// static tables in FEWZ.cc. getWeights() evaluates arrays of events
 
 #ifdef _8TeV_analysis_
 // 8 TeV FEWZ map is based on file from Alexey
@@ -49,24 +55,74 @@ const double rap_bin_FEWZ8TeV[nrapbins_FEWZ8TeV] = {0.,0.7,1.1,1.9,2.4,1000.0};
 // --------------------------------------
 
 #ifdef _8TeV_analysis_
-//int Find_Index_FEWZ8TeV( double muon_input, bool isPt ); // A.Svyatkovskiy function
 double weight_FEWZ8TeV( double muon_pt, double muon_rap, double mass); // A.Svyatkovskiy function
 #endif
 
 
+// --------------------------------------
+
+#ifndef _8TeV_analysis_
+// Copy of a histogram axis. findClamped gives the same bin as
+// TAxis::FindBin, except that the under- and overflow values are
+// assigned to the first and the last bin. The index is 0-based
+
+struct FEWZAxis_t {
+  int fN;
+  double fXmin, fXmax;
+  std::vector<double> fEdges; // empty for an axis with fixed bin width
+
+  FEWZAxis_t() : fN(0), fXmin(0.), fXmax(0.), fEdges() {}
+  void set(const TAxis *ax);
+
+  int findClamped(double x) const {
+    if (x<fXmin) return 0;
+    if (x>=fXmax) return fN-1;
+    int idx= (fEdges.size()) ?
+      int(std::upper_bound(fEdges.begin(),fEdges.end(),x) - fEdges.begin()) - 1 :
+      int(fN*(x-fXmin)/(fXmax-fXmin));
+    if (idx<0) idx=0; else if (idx>=fN) idx=fN-1;
+    return idx;
+  }
+};
+#endif
+
 // --------------------------------------
 
 class FEWZ_t {
 protected:
   TH2D *weights[_nMassBinsFEWZ], *weightErrors[_nMassBinsFEWZ];
   bool fInitialized, fCutZPT100;
+#ifndef _8TeV_analysis_
+  DYTools::BinLocator_t fMassLocator;
+  std::vector<FEWZAxis_t> fPtAxes, fYAxes; // [mass_bin]
+  std::vector<int> fOffsets; // [mass_bin], the first pair of the bin in fTable
+  std::vector<Double_t> fTable; // (weight,error) pairs, [mass][pt][y]
+
+  void buildTable_7TeV();
+  // returns the position of the (weight,error) pair or -1, if the mass
+  // is below the maps
+  int findCell_7TeV(Double_t gen_ee_mass, Double_t gen_pt, Double_t gen_rapidity) const {
+    int ibin=fMassLocator.find(gen_ee_mass);
+    if (ibin==-1) {
+      if (!(gen_ee_mass >= _massBinLimitsFEWZ[_nMassBinsFEWZ])) return -1;
+      ibin=_nMassBinsFEWZ-1;
+    }
+    const FEWZAxis_t &ptAxis=fPtAxes[ibin];
+    int ptBin=ptAxis.findClamped(gen_pt);
+    // Apply PT cut if needed
+    if (fCutZPT100 && (ptBin==ptAxis.fN-1)) ptBin--;
+    const int yBin=fYAxes[ibin].findClamped(gen_rapidity);
+    return fOffsets[ibin] + 2*(ptBin*fYAxes[ibin].fN + yBin);
+  }
+#endif
 public:
   FEWZ_t(bool loadWeights=true, bool do_cutZPT100=true);
   bool isInitialized() const { return fInitialized; }
   bool cutZPT100() const { return fCutZPT100; }
 
   // ------
-  // this method is used for 7 TeV analysis
+  // this method was used for 7 TeV analysis. getWeight uses the table
+  // built from the same histograms
   // ------
 #ifndef _8TeV_analysis_
   Double_t getValue_7TeV(TH2D **values, Double_t gen_ee_mass, Double_t gen_pt, Double_t gen_rapidity) const {
@@ -167,11 +223,16 @@ public:
   // main method
   // ------
 
-  Double_t getWeight(Double_t gen_ee_mass, Double_t gen_pt, Double_t gen_rapidity) {
+  Double_t getWeight(Double_t gen_ee_mass, Double_t gen_pt, Double_t gen_rapidity) const {
 #ifdef _8TeV_analysis_
     return weight_FEWZ8TeV(gen_pt,fabs(gen_rapidity),gen_ee_mass);
 #else
-    return getValue(weights,gen_ee_mass,gen_pt,gen_rapidity);
+    if (!fInitialized) {
+      std::cout << "Error: FEWZ::getWeight is requested on uninitialized object\n";
+      return Double_t(0);
+    }
+    const int idx=findCell_7TeV(gen_ee_mass,gen_pt,gen_rapidity);
+    return (idx==-1) ? 1.0 : fTable[idx];
 #endif
   }
 
@@ -180,15 +241,29 @@ public:
   // ------
 
 
-  Double_t getWeightError(Double_t gen_ee_mass, Double_t gen_pt, Double_t gen_rapidity) {
+  Double_t getWeightError(Double_t gen_ee_mass, Double_t gen_pt, Double_t gen_rapidity) const {
 #ifdef _8TeV_analysis_
     if (0) std::cout << "getWeightError(mass=" << gen_ee_mass << ", pt=" << gen_pt << ", gen_rapidity=" << gen_rapidity << ")\n"; // get rid of a compiler warning
     return 0.;
 #else
-    return getValue(weightErrors,gen_ee_mass,gen_pt,gen_rapidity);
+    if (!fInitialized) {
+      std::cout << "Error: FEWZ::getWeightError is requested on uninitialized object\n";
+      return Double_t(0);
+    }
+    const int idx=findCell_7TeV(gen_ee_mass,gen_pt,gen_rapidity);
+    return (idx==-1) ? 1.0 : fTable[idx+1];
 #endif
   }
 
+  // ------
+  // weights (and errors, if weightErrs is not NULL) for n events.
+  // The errors are 0 in 8 TeV analysis
+  // ------
+
+  void getWeights(int n, const Double_t *gen_ee_mass, const Double_t *gen_pt,
+		  const Double_t *gen_rapidity,
+		  Double_t *weightsOut, Double_t *weightErrs=NULL) const;
+
 };
 
 // --------------------------------------
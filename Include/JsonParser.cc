@@ -4,6 +4,7 @@
 #include <fstream>
 #include <iomanip>
 #include <ctype.h>
+#include <algorithm>
 
 using namespace std;
 
@@ -45,7 +46,7 @@ void JsonParser::Initialize(TString filename){
   vector<int> secondLumiDigits;
   secondLumiDigits.clear();
   int secondLumi = 0;
-  vector<int> allRunLumis;
+  vector<LumiRange_t> allRunLumis;
   allRunLumis.clear();
   while ( ! jsonFile.eof() ) {
     
@@ -111,10 +112,10 @@ void JsonParser::Initialize(TString filename){
       firstLumiDigits.clear();
       secondLumiDigits.clear();
       depth = d_insideOuterBracket;
-      // Now we have starting and ending lumi for this lumi block. Put all relevant
-      // lumis into the list of lumis for this run
-      for(int ilumi = firstLumi; ilumi <= secondLumi; ilumi++)
-	allRunLumis.push_back(ilumi);
+      // Now we have starting and ending lumi for this lumi block.
+      // Keep the range itself, not the individual lumis
+      if (firstLumi <= secondLumi)
+	allRunLumis.push_back(LumiRange_t(firstLumi,secondLumi));
 //       cout << "       lumi " << firstLumi << "    " << secondLumi << endl;
     } else if( depth == d_insideOuterBracket && x==','){
       // the next range of lumis is about to start, do nothing
@@ -135,42 +136,122 @@ void JsonParser::Initialize(TString filename){
     
   }
   jsonFile.close();
-  
+
+  if( _runList.size() != _lumiStatusList.size() ){
+    cout << "JsonParser::ERROR: internal bookkeeping inconsistency" << endl;
+    return;
+  }
+
+  Compactify();
   _isInitialized = true;
   
 }
 
-bool JsonParser::HasRunLumi(int run, int lumi){
+// ------------------------------------------------------------
 
-  bool result = false;
+namespace JsonParserAux {
+  typedef JsonParser::LumiRange_t LumiRange_t;
 
-  if( ! _isInitialized ) {
-    cout << "JsonParser::ERROR: attempt to use without initialization" << endl;
-    return result;
+  struct RunSortHelper_t {
+    const vector<int> *runs;
+    RunSortHelper_t(const vector<int> &r) : runs(&r) {}
+    bool operator()(unsigned int i, unsigned int j) const {
+      return ((*runs)[i] < (*runs)[j]);
+    }
+  };
+
+  // true if the range ends before the given lumi
+  inline bool rangeEndsBefore(const LumiRange_t &r, int lumi) {
+    return (r.second < lumi);
   }
+};
 
-  if( _runList.size() != _lumiStatusList.size() ){
-    cout << "JsonParser::ERROR: internal bookkeeping inconsistency" << endl;
-    return result;
+// ------------------------------------------------------------
+
+void JsonParser::Compactify(){
+
+  // sort the runs keeping the lumi lists attached
+  vector<unsigned int> order(_runList.size());
+  for (unsigned int i=0; i<order.size(); i++) order[i]=i;
+  std::stable_sort(order.begin(),order.end(),
+		   JsonParserAux::RunSortHelper_t(_runList));
+
+  vector<int> runs;
+  vector < vector<LumiRange_t> > lumis;
+  runs.reserve(_runList.size());
+  lumis.reserve(_runList.size());
+  for (unsigned int i=0; i<order.size(); i++) {
+    const int run=_runList[order[i]];
+    vector<LumiRange_t> &src=_lumiStatusList[order[i]];
+    if (runs.size() && (runs.back()==run)) {
+      // the same run listed twice: join the ranges
+      lumis.back().insert(lumis.back().end(),src.begin(),src.end());
+    }
+    else {
+      runs.push_back(run);
+      lumis.push_back(src);
+    }
   }
-  
-  vector < vector < int > >::iterator iter_irun;
-  vector<int>        ::iterator iter_ilumi;
-  
-  int irun = -1;
-  for(iter_irun = _lumiStatusList.begin(); iter_irun != _lumiStatusList.end(); iter_irun++){
-    irun++;
-    if( result ) break;
-    if ( _runList[irun] != run ) continue;
-    for(iter_ilumi = (*iter_irun).begin(); iter_ilumi != (*iter_irun).end(); iter_ilumi++){
-      if( (*iter_ilumi) == lumi ) {
-	result = true;
-	break;
+
+  // sort the ranges and merge the overlapping or adjacent ones
+  for (unsigned int ir=0; ir<lumis.size(); ir++) {
+    vector<LumiRange_t> &v=lumis[ir];
+    std::sort(v.begin(),v.end());
+    vector<LumiRange_t> merged;
+    merged.reserve(v.size());
+    for (unsigned int i=0; i<v.size(); i++) {
+      if (merged.size() && (v[i].first <= merged.back().second+1)) {
+	if (v[i].second > merged.back().second)
+	  merged.back().second=v[i].second;
       }
+      else merged.push_back(v[i]);
     }
+    v.swap(merged);
   }
 
-  return result;
+  _runList.swap(runs);
+  _lumiStatusList.swap(lumis);
+  _lastRun=-1;
+  _lastRunIdx=-1;
+}
+
+// ------------------------------------------------------------
+
+int JsonParser::FindRunIdx(int run){
+  if (run==_lastRun) return _lastRunIdx;
+  vector<int>::const_iterator it=
+    std::lower_bound(_runList.begin(),_runList.end(),run);
+  int idx=((it!=_runList.end()) && (*it==run)) ? int(it-_runList.begin()) : -1;
+  _lastRun=run;
+  _lastRunIdx=idx;
+  return idx;
+}
+
+// ------------------------------------------------------------
+
+int JsonParser::NLumiRanges() const {
+  int count=0;
+  for (unsigned int i=0; i<_lumiStatusList.size(); i++)
+    count+=int(_lumiStatusList[i].size());
+  return count;
+}
+
+bool JsonParser::HasRunLumi(int run, int lumi){
+
+  if( ! _isInitialized ) {
+    cout << "JsonParser::ERROR: attempt to use without initialization" << endl;
+    return false;
+  }
+
+  const int irun=FindRunIdx(run);
+  if (irun<0) return false;
+
+  // the first range that does not end before the lumi
+  const vector<LumiRange_t> &ranges=_lumiStatusList[irun];
+  vector<LumiRange_t>::const_iterator it=
+    std::lower_bound(ranges.begin(),ranges.end(),lumi,
+		     JsonParserAux::rangeEndsBefore);
+  return ((it!=ranges.end()) && (it->first <= lumi));
 }
 
 void JsonParser::Reset(){
@@ -178,6 +259,8 @@ void JsonParser::Reset(){
   _runList.clear();
   _lumiStatusList.clear();
   _isInitialized = false;
+  _lastRun = -1;
+  _lastRunIdx = -1;
 
 }
 
@@ -203,34 +286,13 @@ void JsonParser::Print(){
     return;
   }
   
-  vector < vector < int > >::iterator iter_irun;
-  vector<int>        ::iterator iter_ilumi;
-  
-  int irun = -1;
-  for(iter_irun = _lumiStatusList.begin(); iter_irun != _lumiStatusList.end(); iter_irun++){
-    irun++;
+  for(unsigned int irun=0; irun<_runList.size(); irun++){
     printf("Run %d\n", _runList[irun]);
     printf("  lumis: ");
-    bool printedDash = false;
-    bool previousNotPrinted = false;
-    for(iter_ilumi = (*iter_irun).begin(); iter_ilumi != (*iter_irun).end(); iter_ilumi++){
-      bool first = ( iter_ilumi == (*iter_irun).begin() );
-      bool last  = ( iter_ilumi == (*iter_irun).end() - 1 );
-      if( ! ( (*(iter_ilumi-1)) == (*iter_ilumi) - 1) || first || last ){
-	if(previousNotPrinted && !last) {
-	  printf(" %d", (*(iter_ilumi-1)));
-	}
-	printf("  %d", (*iter_ilumi));
-	printedDash = false;
-	previousNotPrinted = false;
-      } else {
-	previousNotPrinted = true;
-	if( !printedDash){
-	  printf(" -");
-	  printedDash = true;
-	}
-      }
-//       prev = (*iter_ilumi);
+    const vector<LumiRange_t> &ranges=_lumiStatusList[irun];
+    for(unsigned int i=0; i<ranges.size(); i++){
+      if (ranges[i].first==ranges[i].second) printf("  %d", ranges[i].first);
+      else printf("  %d - %d", ranges[i].first, ranges[i].second);
     }
     printf("\n");
   }
@@ -3,6 +3,7 @@
 
 #include <TString.h>
 #include <vector>
+#include <utility>
 
 class JsonParser {
 
@@ -14,6 +15,8 @@ public:
   void Initialize(TString filename);
   bool HasRunLumi(int run, int lumi);
   void Reset();
+  int  NRuns() const { return int(_runList.size()); }
+  int  NLumiRanges() const;
   void Print();
   int AssembleNumber(vector<int> data);
 
@@ -25,14 +28,26 @@ public:
   };
 
 
+  // [first,last] lumi section range, both ends inclusive
+  typedef std::pair<int,int> LumiRange_t;
+
 private:
 
-  vector <int>            _runList;
-  vector < vector<int> >  _lumiStatusList;
+  // Sort the runs, sort and merge the lumi ranges of every run.
+  // Called once at the end of Initialize
+  void Compactify();
+  // Index of the run in _runList, or -1. The last hit is cached,
+  // since the events come ordered in runs
+  int  FindRunIdx(int run);
+
+  vector <int>                    _runList;   // sorted
+  vector < vector<LumiRange_t> >  _lumiStatusList; // sorted, non-overlapping
 
   bool                    _isInitialized;
+  int                     _lastRun;    //! cache of the last queried run
+  int                     _lastRunIdx; //! its index in _runList (or -1)
 
-  ClassDef(JsonParser,1)
+  ClassDef(JsonParser,2)
 
 };
 #endif
@@ -0,0 +1,210 @@
+#include "../Include/SignalMCReader.hh"
+#include "../Include/EventSelector.hh"
+#include "../Include/MyTools.hh"
+#include <TSystem.h>
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
+
+SignalMCConsumer_t::SignalMCConsumer_t(const TString &name, Long64_t maxEntry) :
+  FName(name), FWorkDir(gSystem->WorkingDirectory()),
+  FMaxEntry(maxEntry), FRandom(NULL), FActive(1)
+{}
+
+// --------------------------------------------------------------
+
+SignalMCConsumer_t::~SignalMCConsumer_t() {
+  if (FRandom) delete FRandom;
+}
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
+
+SignalMCReader_t::SignalMCReader_t() :
+  FConsumers(), FLumis(),
+  FFile(NULL), FTree(NULL),
+  FInfoBr(NULL), FGenBr(NULL), FDielectronBr(NULL), FPVBr(NULL),
+  FInfo(new mithep::TEventInfo()),
+  FGen(new mithep::TGenInfo()),
+  FDielectronArr(new TClonesArray("mithep::TDielectron")),
+  FPVArr(new TClonesArray("mithep::TVertex")),
+  FIFile(0), FIEntry(-1), FDielectronEntry(-1), FPVEntry(-1),
+  FScale(1.), FFinished(0)
+{}
+
+// --------------------------------------------------------------
+
+SignalMCReader_t::~SignalMCReader_t() {
+  for (unsigned int i=0; i<FConsumers.size(); ++i) delete FConsumers[i];
+  FConsumers.clear();
+  if (FFile) { delete FFile; FFile=0; FTree=0; }
+  delete FInfo;
+  delete FGen;
+  delete FDielectronArr;
+  delete FPVArr;
+}
+
+// --------------------------------------------------------------
+
+void SignalMCReader_t::addConsumer(SignalMCConsumer_t *consumer) {
+  assert(consumer);
+  std::cout << "SignalMCReader: added consumer <" << consumer->name()
+	    << "> (workDir=<" << consumer->workDir() << ">)\n";
+  FConsumers.push_back(consumer);
+}
+
+// --------------------------------------------------------------
+
+int SignalMCReader_t::callConsumer(SignalMCConsumer_t *c, int action) {
+  TRandom *savedRandom=gRandom;
+  if (c->random()) gRandom=c->random();
+  int res=0;
+  switch(action) {
+  case 0: res=c->beginFile(*this); break;
+  case 1: res=c->processEvent(*this); break;
+  case 2: res=c->endFile(*this); break;
+  case 3: {
+    TString cwd=gSystem->WorkingDirectory();
+    gSystem->ChangeDirectory(c->workDir());
+    res=c->finish();
+    gSystem->ChangeDirectory(cwd);
+  }
+    break;
+  default:
+    std::cout << "SignalMCReader::callConsumer: unknown action=" << action << "\n";
+  }
+  gRandom=savedRandom;
+  return res;
+}
+
+// --------------------------------------------------------------
+
+int SignalMCReader_t::run(const MCInputFileMgr_t &mcInp) {
+  if (FFinished) {
+    std::cout << "SignalMCReader::run: the consumers have been finished\n";
+    return 0;
+  }
+  if (!FConsumers.size()) {
+    std::cout << "SignalMCReader::run: no consumers\n";
+    return 0;
+  }
+
+  // events are needed only if at least one consumer is active
+  int needEvents=0;
+  for (unsigned int ic=0; ic<FConsumers.size(); ++ic) {
+    if (FConsumers[ic]->active()) needEvents=1;
+  }
+
+  FLumis=mcInp.lumis();
+  std::vector<SignalMCConsumer_t*> activeV;
+  activeV.reserve(FConsumers.size());
+
+  for (UInt_t ifile=0; needEvents && (ifile<mcInp.size()); ++ifile) {
+    FIFile=ifile;
+
+    // Read input file
+    std::cout << "Processing " << mcInp.fileName(ifile) << "..." << std::endl;
+    FFile = new TFile(mcInp.fileName(ifile));
+    assert(FFile);
+
+    // Get the TTrees
+    FTree = (TTree*)FFile->Get("Events"); assert(FTree);
+
+    // Find weight for events for this file
+    // The first file in the list comes with weight 1,
+    // all subsequent ones are normalized to xsection and luminosity
+    Double_t xsec=mcInp.xsec(ifile);
+    AdjustXSectionForSkim(FFile,xsec,FTree->GetEntries(),1);
+    FLumis[ifile] = FTree->GetEntries()/xsec;
+    FScale = FLumis[0]/FLumis[ifile];
+    std::cout << "       -> sample weight is " << FScale << std::endl;
+
+    // Set branch address to structures that will store the info
+    FTree->SetBranchAddress("Info",&FInfo);  FInfoBr = FTree->GetBranch("Info");
+    FTree->SetBranchAddress("Gen",&FGen);    FGenBr = FTree->GetBranch("Gen");
+    assert(FInfoBr && FGenBr);
+    FDielectronBr = FTree->GetBranch("Dielectron");
+    if (FDielectronBr) FTree->SetBranchAddress("Dielectron",&FDielectronArr);
+    FPVBr = FTree->GetBranch("PV");
+    if (FPVBr) FTree->SetBranchAddress("PV",&FPVArr);
+    FIEntry=-1; FDielectronEntry=-1; FPVEntry=-1;
+
+    for (unsigned int ic=0; ic<FConsumers.size(); ++ic) {
+      if (FConsumers[ic]->active() && !callConsumer(FConsumers[ic],0)) {
+	std::cout << "SignalMCReader::run: error in beginFile of <"
+		  << FConsumers[ic]->name() << ">\n";
+	return 0;
+      }
+    }
+
+    // loop over events
+    const Long64_t nEntries=FTree->GetEntries();
+    for (Long64_t ientry=0; ientry<nEntries; ientry++) {
+      if (ientry%1000000==0) printProgress("ientry=",ientry,FTree->GetEntriesFast());
+
+      // consumers that want this event
+      activeV.clear();
+      for (unsigned int ic=0; ic<FConsumers.size(); ++ic) {
+	if (FConsumers[ic]->acceptsEntry(ientry)) activeV.push_back(FConsumers[ic]);
+      }
+      if (!activeV.size()) break; // entry limits of all consumers were reached
+
+      FIEntry=ientry;
+      FGenBr->GetEntry(ientry);
+      FInfoBr->GetEntry(ientry);
+
+      for (unsigned int ic=0; ic<activeV.size(); ++ic) {
+	if (!callConsumer(activeV[ic],1)) {
+	  std::cout << "SignalMCReader::run: error in processEvent of <"
+		    << activeV[ic]->name() << "> at ientry=" << ientry << "\n";
+	  return 0;
+	}
+      }
+    }
+
+    for (unsigned int ic=0; ic<FConsumers.size(); ++ic) {
+      if (FConsumers[ic]->active() && !callConsumer(FConsumers[ic],2)) {
+	std::cout << "SignalMCReader::run: error in endFile of <"
+		  << FConsumers[ic]->name() << ">\n";
+	return 0;
+      }
+    }
+
+    FInfoBr=0; FGenBr=0; FDielectronBr=0; FPVBr=0;
+    delete FFile;
+    FFile=0; FTree=0;
+  }
+
+  return this->finish();
+}
+
+// --------------------------------------------------------------
+
+int SignalMCReader_t::run(const TString &mcInputFile) {
+  MCInputFileMgr_t mcInp;
+  if (!mcInp.Load(mcInputFile)) {
+    std::cout << "SignalMCReader::run: failed to load mc input file <" << mcInputFile << ">\n";
+    return 0;
+  }
+  return this->run(mcInp);
+}
+
+// --------------------------------------------------------------
+
+int SignalMCReader_t::finish() {
+  if (FFinished) return 1;
+  FFinished=1;
+  int ok=1;
+  for (unsigned int ic=0; ic<FConsumers.size(); ++ic) {
+    std::cout << "\nSignalMCReader: finishing <" << FConsumers[ic]->name() << ">\n";
+    if (!callConsumer(FConsumers[ic],3)) {
+      std::cout << "SignalMCReader::finish: error in <"
+		<< FConsumers[ic]->name() << ">\n";
+      ok=0;
+    }
+  }
+  return ok;
+}
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
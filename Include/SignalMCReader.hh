@@ -0,0 +1,154 @@
+#ifndef SignalMCReader_HH
+#define SignalMCReader_HH
+
+#include <TROOT.h>
+#include <TString.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TClonesArray.h>
+#include <TRandom.h>
+#include <vector>
+#include <iostream>
+#include <assert.h>
+
+#include "../Include/TEventInfo.hh"
+#include "../Include/TGenInfo.hh"
+#include "../Include/InputFileMgr.hh"
+
+// --------------------------------------------------------
+//
+// Single-pass reader of the signal MC ntuples.
+//
+// Acceptance, efficiency, unfolding and FSR macros register their
+// calculations as consumers. The reader opens every signal MC file
+// once, reads Info and Gen for each event and hands the event
+// to all active consumers. Dielectron and PV branches are read
+// only if a consumer asks for them, and at most once per event.
+//
+// A consumer keeps the working directory it was created in. The
+// output of the consumer (plots, text tables) is produced from
+// that directory, so that the files end up in the same places
+// as when the macro runs standalone.
+//
+// If a consumer has its own random number generator, it is
+// installed as gRandom for the duration of each call to the consumer.
+// This way the random sequence seen by the consumer does not depend
+// on the other consumers.
+//
+// --------------------------------------------------------
+
+class SignalMCReader_t;
+
+// --------------------------------------------------------
+
+class SignalMCConsumer_t {
+protected:
+  TString FName;
+  TString FWorkDir;    // working directory at the creation
+  Long64_t FMaxEntry;  // entries above this index are not processed (-1: no limit)
+  TRandom *FRandom;    // private generator (owned), or 0 to use gRandom
+  int FActive;         // whether the consumer needs events
+public:
+  SignalMCConsumer_t(const TString &name, Long64_t maxEntry=-1);
+  virtual ~SignalMCConsumer_t();
+
+  // access
+  const TString& name() const { return FName; }
+  const TString& workDir() const { return FWorkDir; }
+  Long64_t maxEntry() const { return FMaxEntry; }
+  void maxEntry(Long64_t idx) { FMaxEntry=idx; }
+  int active() const { return FActive; }
+  void active(int a) { FActive=a; }
+  TRandom* random() const { return FRandom; }
+  void random(TRandom *rnd) { if (FRandom) delete FRandom; FRandom=rnd; }
+
+  int acceptsEntry(Long64_t ientry) const {
+    return (FActive && ((FMaxEntry<0) || (ientry<=FMaxEntry))) ? 1:0;
+  }
+
+  // The event loop.
+  // beginFile and endFile are called for each input file,
+  // processEvent -- for every event accepted by acceptsEntry.
+  // A return value 0 signals an error and stops the loop. Events
+  // rejected by the selection of the consumer are not errors (return 1).
+  virtual int beginFile(SignalMCReader_t &) { return 1; }
+  virtual int processEvent(SignalMCReader_t &rd) = 0;
+  virtual int endFile(SignalMCReader_t &) { return 1; }
+
+  // Called after all files were processed. Computes
+  // and saves the results of the consumer
+  virtual int finish() = 0;
+};
+
+// --------------------------------------------------------
+
+class SignalMCReader_t {
+protected:
+  std::vector<SignalMCConsumer_t*> FConsumers;  // owned
+  std::vector<Double_t> FLumis;
+  TFile *FFile;
+  TTree *FTree;
+  TBranch *FInfoBr, *FGenBr, *FDielectronBr, *FPVBr;
+  mithep::TEventInfo *FInfo;
+  mithep::TGenInfo *FGen;
+  TClonesArray *FDielectronArr, *FPVArr;
+  UInt_t FIFile;
+  Long64_t FIEntry, FDielectronEntry, FPVEntry;
+  Double_t FScale;
+  int FFinished;
+public:
+  SignalMCReader_t();
+  ~SignalMCReader_t();
+
+  // the reader takes ownership of the consumer
+  void addConsumer(SignalMCConsumer_t *consumer);
+  unsigned int consumerCount() const { return FConsumers.size(); }
+  SignalMCConsumer_t* consumer(unsigned int i) { return FConsumers[i]; }
+
+  // access to the current event
+  UInt_t ifile() const { return FIFile; }
+  Long64_t ientry() const { return FIEntry; }
+  Long64_t entries() const { return (FTree) ? FTree->GetEntries() : 0; }
+  Double_t scale() const { return FScale; }  // sample weight of the current file
+  const std::vector<Double_t>& lumis() const { return FLumis; }
+  TFile* file() { return FFile; }
+  TTree* tree() { return FTree; }
+  mithep::TEventInfo* info() { return FInfo; }
+  mithep::TGenInfo* gen() { return FGen; }
+
+  // the branches are read on the first request for the current entry
+  TClonesArray* dielectronArr() {
+    if (FDielectronEntry!=FIEntry) {
+      assert(FDielectronBr);
+      FDielectronArr->Clear();
+      FDielectronBr->GetEntry(FIEntry);
+      FDielectronEntry=FIEntry;
+    }
+    return FDielectronArr;
+  }
+
+  TClonesArray* pvArr() {
+    if (FPVEntry!=FIEntry) {
+      assert(FPVBr);
+      FPVArr->Clear();
+      FPVBr->GetEntry(FIEntry);
+      FPVEntry=FIEntry;
+    }
+    return FPVArr;
+  }
+
+  // Process all files of the signal MC sample. Returns 0 on error
+  int run(const MCInputFileMgr_t &mcInp);
+  int run(const TString &mcInputFile);
+
+  // Call finish() of every consumer. Called from run() too
+  int finish();
+
+protected:
+  int callConsumer(SignalMCConsumer_t *c, int action);
+};
+
+// --------------------------------------------------------
+
+#endif
@@ -6,6 +6,8 @@
 #include <TString.h>
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <algorithm>
 
 // -----------------------------------------
 //
@@ -162,6 +164,20 @@ std::string PrintBitsToStdString(T n, const char *msg=NULL, int compact=0) {
 // -----------------------------------------------
 // -----------------------------------------------
 
+// All trigger masks of a run, as returned by TriggerSelection::getTriggerBits.
+// The tag-and-probe arrays are indexed by idEffTrigger (0=false, 1=true)
+
+struct TriggerBits_t {
+  UInt_t  firstRun;              // first run of the interval with these masks
+  ULong_t event, leadingObj, trailingObj;
+  ULong_t eventSCtoGSF, leadingObjSCtoGSF;
+  ULong_t eventTagProbe[2], tagObj[2], probeObjTight[2], probeObjLoose[2];
+
+  bool operator<(const TriggerBits_t &b) const { return (firstRun < b.firstRun); }
+};
+
+// -----------------------------------------------
+
 class TriggerSelection{
   
  public:
@@ -169,27 +185,30 @@ class TriggerSelection{
     _constants(constantsSet),
     _isData(isData),
     _run(run),
-    _hltEffCalcAlgo(hltEffCalc)
+    _hltEffCalcAlgo(hltEffCalc),
+    _bitsTable(), _bits(), _bitsValid(false)
   {}
 
   TriggerSelection(const TString& constantsSetString, bool isData, int run):
     _constants(DetermineTriggerSet(constantsSetString)),
     _isData(isData),
     _run(run),
-    _hltEffCalcAlgo(DetermineHLTEfficiencyCalc(constantsSetString))
+    _hltEffCalcAlgo(DetermineHLTEfficiencyCalc(constantsSetString)),
+    _bitsTable(), _bits(), _bitsValid(false)
   {}
 
   TriggerSelection(const TriggerSelection &ts) :
-    _constants(ts._constants), _isData(ts._isData), _run(ts._run), _hltEffCalcAlgo(ts._hltEffCalcAlgo)
+    _constants(ts._constants), _isData(ts._isData), _run(ts._run), _hltEffCalcAlgo(ts._hltEffCalcAlgo),
+    _bitsTable(ts._bitsTable), _bits(ts._bits), _bitsValid(ts._bitsValid)
   {}
 
   // Access
   TriggerConstantSet triggerSet() const { return _constants; }
-  void triggerSet(TriggerConstantSet ts) { _constants=ts; }
+  void triggerSet(TriggerConstantSet ts) { if (_constants!=ts) { _constants=ts; clearTriggerBitsCache(); } }
   bool actOnData() const { return _isData; }
-  void actOnData(bool act_on_data) { _isData = act_on_data; }
+  void actOnData(bool act_on_data) { if (_isData!=act_on_data) { _isData = act_on_data; clearTriggerBitsCache(); } }
   HLTEfficiencyCalcDef hltEffCalcMethod() const { return _hltEffCalcAlgo; }
-  void hltEffCalcMethod(HLTEfficiencyCalcDef hltEffCalc) {  _hltEffCalcAlgo = hltEffCalc; }
+  void hltEffCalcMethod(HLTEfficiencyCalcDef hltEffCalc) { if (_hltEffCalcAlgo!=hltEffCalc) { _hltEffCalcAlgo = hltEffCalc; clearTriggerBitsCache(); } }
   bool isDefined() const { return (_constants != TrigSet_UNDEFINED) ? true : false; }
   bool hltEffMethodIsDefined() const { return (_hltEffCalcAlgo != HLTEffCalc_UNDEFINED) ? true : false; }
   bool hltEffMethodIs2011New() const { return (_hltEffCalcAlgo == HLTEffCalc_2011New) ? true : false; }
@@ -540,82 +559,145 @@ class TriggerSelection{
     return bits;
   }
 
+  // All trigger bits of the run.
+  // The masks above depend on the run only through a few run ranges.
+  // On the first call, the masks are evaluated once per run interval
+  // and kept in a table sorted by the first run of the interval.
+  // The bundle of the last requested run is memoized, thus in the
+  // event loops the lookup costs one comparison while the run does
+  // not change. The cache is not protected by a mutex: each thread
+  // has to use its own copy of TriggerSelection
+  const TriggerBits_t& getTriggerBits(UInt_t run) const {
+    if (_bitsValid && (_bits.firstRun==run)) return _bits;
+    if (run==0) {
+      // run=0 has the special meaning (obsolete member _run) in some masks
+      fillTriggerBits(0,_bits);
+    }
+    else {
+      if (_bitsTable.empty()) buildTriggerBitsTable();
+      TriggerBits_t key;
+      key.firstRun=run;
+      std::vector<TriggerBits_t>::const_iterator it=
+	std::upper_bound(_bitsTable.begin(),_bitsTable.end(),key);
+      _bits=*(--it);    // the first interval starts at run 1
+    }
+    _bits.firstRun=run; // the key of the memoized bundle
+    _bitsValid=true;
+    return _bits;
+  }
+
   // 
   // The functions that implement cuts on trigger bits
   //
 
   Bool_t matchEventTriggerBit(ULong_t bit, UInt_t run) const {
-    if( ! (bit & getEventTriggerBit(run) ) )
+    if( ! (bit & getTriggerBits(run).event ) )
       return kFALSE;
     return kTRUE;
   }
 
   Bool_t matchLeadingTriggerObjectBit(ULong_t bit, UInt_t run) const { 
-    if( ! (bit & getLeadingTriggerObjectBit(run) ) )
+    if( ! (bit & getTriggerBits(run).leadingObj ) )
       return kFALSE;
     return kTRUE;    
   }
 
   Bool_t matchTrailingTriggerObjectBit(ULong_t bit, UInt_t run) const { 
-    if( ! (bit & getTrailingTriggerObjectBit(run) ) )
+    if( ! (bit & getTriggerBits(run).trailingObj ) )
       return kFALSE;
     return kTRUE;    
   }
 
   Bool_t matchEventTriggerBit_SCtoGSF(ULong_t bit, UInt_t run) const {
-    if( ! (bit & getEventTriggerBit_SCtoGSF(run) ) )
+    if( ! (bit & getTriggerBits(run).eventSCtoGSF ) )
       return kFALSE;
     return kTRUE;    
   }
 
   Bool_t matchLeadingTriggerObjectBit_SCtoGSF(ULong_t bit, UInt_t run) const { 
-    if( ! (bit & getLeadingTriggerObjectBit_SCtoGSF(run) ) )
+    if( ! (bit & getTriggerBits(run).leadingObjSCtoGSF ) )
       return kFALSE;
     return kTRUE;    
   }
 
   Bool_t matchEventTriggerBit_TagProbe(ULong_t bit, UInt_t run, bool idEffTrigger) const {
-    if( ! (bit & getEventTriggerBit_TagProbe(run,idEffTrigger) ) )
+    if( ! (bit & getTriggerBits(run).eventTagProbe[(idEffTrigger) ? 1:0] ) )
       return kFALSE;
     return kTRUE;    
   }
 
   Bool_t matchTagTriggerObjBit(ULong_t bit, UInt_t run, bool idEffTrigger) const { 
-    if( ! (bit & getTagTriggerObjBit(run,idEffTrigger) ) )
+    if( ! (bit & getTriggerBits(run).tagObj[(idEffTrigger) ? 1:0] ) )
       return kFALSE;
     return kTRUE;    
   }
 
 
   Bool_t matchProbeTriggerObjBit_Tight(ULong_t bit, UInt_t run, bool idEffTrigger) const {
-    if( ! (bit & getProbeTriggerObjBit_Tight(run,idEffTrigger) ) )
+    if( ! (bit & getTriggerBits(run).probeObjTight[(idEffTrigger) ? 1:0] ) )
       return kFALSE;
     return kTRUE;    
   }
 
   Bool_t matchProbeTriggerObjBit_Loose(ULong_t bit, UInt_t run, bool idEffTrigger) const { 
-    if( ! (bit & getProbeTriggerObjBit_Loose(run,idEffTrigger) ) )
+    if( ! (bit & getTriggerBits(run).probeObjLoose[(idEffTrigger) ? 1:0] ) )
       return kFALSE;
     return kTRUE;    
   }
 
   Bool_t matchTwoTriggerObjectsAnyOrder(ULong_t bit1, ULong_t bit2, UInt_t run) const {
+    const TriggerBits_t &tb=getTriggerBits(run);
     if( ! ( 
-	   (matchLeadingTriggerObjectBit(bit1, run) &&
-	    matchTrailingTriggerObjectBit(bit2, run) )
+	   ((bit1 & tb.leadingObj) && (bit2 & tb.trailingObj))
 	   ||
-	   (matchLeadingTriggerObjectBit(bit2, run) &&
-	    matchTrailingTriggerObjectBit(bit1, run) ) ) )
+	   ((bit2 & tb.leadingObj) && (bit1 & tb.trailingObj)) ) )
       return kFALSE;
     return kTRUE;
   }
  
+ protected:
+  void clearTriggerBitsCache() { _bitsTable.clear(); _bitsValid=false; }
+
+  void fillTriggerBits(UInt_t run, TriggerBits_t &tb) const {
+    tb.firstRun= run;
+    tb.event = getEventTriggerBit(run);
+    tb.leadingObj = getLeadingTriggerObjectBit(run);
+    tb.trailingObj = getTrailingTriggerObjectBit(run);
+    tb.eventSCtoGSF = getEventTriggerBit_SCtoGSF(run);
+    tb.leadingObjSCtoGSF = getLeadingTriggerObjectBit_SCtoGSF(run);
+    for (int i=0; i<2; ++i) {
+      const bool idEffTrigger=(i==1) ? true : false;
+      tb.eventTagProbe[i] = getEventTriggerBit_TagProbe(run,idEffTrigger);
+      tb.tagObj[i] = getTagTriggerObjBit(run,idEffTrigger);
+      tb.probeObjTight[i] = getProbeTriggerObjBit_Tight(run,idEffTrigger);
+      tb.probeObjLoose[i] = getProbeTriggerObjBit_Loose(run,idEffTrigger);
+    }
+  }
+
+  // The boundaries are the first runs of all run ranges used in
+  // validRun and in the trigger bit functions above. A new run range
+  // in these functions has to be added here as well
+  void buildTriggerBitsTable() const {
+    const UInt_t runBoundaries[] = { 1, 150000, 
+				     cFirstEvent2011ASingleEG, 165088,
+				     170054, cLastEvent2011ASingleEG+1,
+				     cFirstEvent2011ADoubleEG, 171050, 171578+1,
+				     cLastEvent2011ADoubleEG+1, cFirstEvent2011B };
+    const int count=sizeof(runBoundaries)/sizeof(UInt_t);
+    _bitsTable.resize(count);
+    for (int i=0; i<count; ++i) fillTriggerBits(runBoundaries[i],_bitsTable[i]);
+    std::sort(_bitsTable.begin(),_bitsTable.end());
+  }
 
  private:
   TriggerConstantSet  _constants;
   bool                _isData;
   int                 _run;             // this is an obsolete data member
   HLTEfficiencyCalcDef   _hltEffCalcAlgo;
+  // run-keyed cache of the trigger bits, see getTriggerBits
+  mutable std::vector<TriggerBits_t> _bitsTable;
+  mutable TriggerBits_t  _bits;
+  mutable bool           _bitsValid;
 
 };
 
@@ -0,0 +1,123 @@
+#ifndef UnfoldingEngine_HH
+#define UnfoldingEngine_HH
+
+#include <TString.h>
+#include <TVectorD.h>
+#include <TMatrixD.h>
+#include <TMatrixDSym.h>
+#include <TMatrixDSparse.h>
+
+#include "../Include/UnfoldingTools.hh"
+
+// Unfolding engines
+//
+// The engines work on the response R(gen,reco), reco = R^T gen, kept in
+// the sparse form, and return the unfolded yields with the full
+// covariance matrix, propagated analytically:
+//
+//  _unfEngineInversion : gen = (R^T)^{-1} reco, banded LU of R
+//  _unfEngineBayes     : iterative Bayesian unfolding (D'Agostini). The
+//                        covariance includes the dependence of the
+//                        unfolding matrix on the previous iterations
+//  _unfEngineTikhonov  : minimizes chi2 + tau^2 |L (gen/prior)|^2, where L
+//                        is the second difference along rapidity in every
+//                        mass slice (along mass in 1D), as in the SVD method
+//
+// The prior (e.g. the MC truth) is the starting point of the Bayesian
+// iterations and the reference shape of the Tikhonov term. If it is not
+// set, a flat prior is used. With warm start, the result of a call becomes
+// the prior of the next one, so that the iterations on similar inputs
+// (systematic variations, pseudo-experiments) converge faster.
+//
+// The covariance is D (V + diag(s)) D^T, where D=d(gen)/d(reco), V is the
+// covariance of the observed yields and s_b = sum_a gen_a^2 RErr_ab^2 is
+// the first-order contribution of the response errors (the residual
+// term of the regularized methods is neglected). Thus the toys of
+// calculateInvertedMatrixErrors are not needed with the engines.
+// The sparse products run on nThreads threads when they are large enough.
+
+namespace unfolding {
+
+  typedef enum { _unfEngineInversion=0, _unfEngineBayes, _unfEngineTikhonov } TUnfoldingEngine_t;
+
+  TString unfoldingEngineName(TUnfoldingEngine_t method);
+
+  class UnfoldingEngine_t {
+  public:
+    UnfoldingEngine_t(TUnfoldingEngine_t set_method, int set_nThreads=1);
+    ~UnfoldingEngine_t();
+
+    // R(gen,reco) and optionally its errors (same sparsity). Returns 1 if ok
+    int setResponse(const TMatrixDSparse &R, const TMatrixDSparse *RErr=NULL);
+    // DetResponseSparse/DetResponseErrSparse, or the dense DetResponse.
+    // The return codes are as in UnfoldingTools.hh
+    int loadResponse(const TString &unfoldingConstFileName);
+
+    void setPrior(const TVectorD &prior) { FPrior.ResizeTo(prior); FPrior=prior; }
+    // yieldsMcPostFsrGenFIArray of the MC reference file of makeUnfoldingMatrix
+    int loadPrior(const TString &refFileName);
+    void clearPrior() { FPrior.ResizeTo(0); }
+    void setIterations(int nIter) { FNIter=nIter; }
+    // the Bayesian iterations stop earlier if the largest relative
+    // change of the yields is below the tolerance
+    void setTolerance(double tolerance) { FTolerance=tolerance; }
+    void setTau(double tau) { FTau=tau; }
+    void setWarmStart(int warmStart) { FWarmStart=warmStart; }
+
+    TUnfoldingEngine_t method() const { return FMethod; }
+    int iterationsDone() const { return FIterationsDone; }
+    const TVectorD& prior() const { return FPrior; }
+
+    // reco and gen are flat-indexed. Returns 1 if ok
+    int unfold(const TVectorD &reco, const TMatrixDSym &recoCov, TVectorD &gen, TMatrixDSym &genCov);
+    // uncorrelated errors of the observed yields
+    int unfold(const TVectorD &reco, const TVectorD &recoErr, TVectorD &gen, TMatrixDSym &genCov);
+
+    // Propagation of other error sources through the last unfolding,
+    // with its derivative D. The unfolded yields do not change
+    int propagate(const TMatrixDSym &recoCov, TMatrixDSym &genCov, int withResponseErrors=0) const;
+    // uncorrelated errors, without the response errors
+    int propagateErrors(const TVectorD &recoErr, TVectorD &genErr) const;
+    // contribution of the response errors alone
+    int responseErrors(TVectorD &genErr) const;
+    const TVectorD& lastResult() const { return FGen; }
+    const TMatrixD& lastDerivative() const { return FD; }
+
+  private:
+    TUnfoldingEngine_t FMethod;
+    int FNThreads;
+    int FNIter, FIterationsDone, FWarmStart;
+    double FTolerance, FTau;
+    TVectorD FPrior;
+    TMatrixDSparse *FR, *FRT, *FRErr;   // response, its transpose and errors
+    TVectorD FEff;                      // sum_reco R(gen,reco)
+    BandedLU_t *FLU;                    // LU of R, inversion
+    TVectorD FGen;                      // result of the last unfolding
+    TMatrixD FD;                        // and its derivative d(gen)/d(reco)
+
+    void clearResponse();
+    void startingPrior(const TVectorD &reco, std::vector<double> &p) const;
+    // the result x and its derivative D
+    int unfoldInversion(const TVectorD &reco, const TMatrixDSym &V, std::vector<double> &x, TMatrixD &D) const;
+    int unfoldBayes(const TVectorD &reco, const TMatrixDSym &V, std::vector<double> &x, TMatrixD &D);
+    int unfoldTikhonov(const TVectorD &reco, const TMatrixDSym &V, std::vector<double> &x, TMatrixD &D) const;
+    // V+diag(s) for the result x
+    void totalRecoCovariance(const TMatrixDSym &V, const TVectorD &x, TMatrixD &Vtot, int withResponseErrors) const;
+
+    UnfoldingEngine_t(const UnfoldingEngine_t&);
+    UnfoldingEngine_t& operator=(const UnfoldingEngine_t&);
+  };
+
+  // unfolding of the flat-indexed yields with the given engine. nIter is
+  // used by the Bayesian unfolding, tau by the Tikhonov method. The prior
+  // is read from refFileName (yieldsMcPostFsrGenFIArray) if the name is
+  // not empty
+  int unfoldWithEngine(TUnfoldingEngine_t method,
+		       const TVectorD &vin, const TVectorD &vinErr,
+		       TVectorD &vout, TMatrixDSym &voutCov,
+		       const TString &unfoldingConstFileName,
+		       const TString &refFileName="",
+		       int nIter=4, double tau=1., int nThreads=1);
+}
+
+#endif
@@ -4,6 +4,9 @@
 #include <TString.h>
 #include <TVectorD.h>
 #include <TMatrixD.h>
+#include <TMatrixDSparse.h>
+#include <vector>
+#include <map>
 
 #include "../Include/DYTools.hh"
 
@@ -55,19 +58,156 @@ namespace unfolding{
 					 TVectorD &errorPropagated);
   
 
-  /* int calculateTotalUnfoldingSystError(const TVectorD &yieldsBeforeUnfolding, 
-				       TVectorD &systUnfolding, 
-				       const TString &fullUnfoldingConstFileName,
-				       const TString &extraUnfoldingErrorsFileName);*/
-
+  // The error due to the unfolding matrix elements is calculated from
+  // DetInvertedResponseErr, unless it is given in systElementsErrorIn
+  // (e.g. UnfoldingEngine_t::responseErrors). yieldsAfterUnfoldingIn
+  // replaces the unfolding by DetInvertedResponse
   int calculateTotalUnfoldingSystErrorFlat
           (const TVectorD &yieldsBeforeUnfolding, 
 	   TVectorD &systUnfolding, 
 	   const TString &fullUnfoldingConstFileName,
-	   const TString &extraUnfoldingErrorsFileName);
+	   const TString &extraUnfoldingErrorsFileName,
+	   const TVectorD *systElementsErrorIn=NULL,
+	   const TVectorD *yieldsAfterUnfoldingIn=NULL);
  
   int checkBinningConsistency(const TString &fileName);
 
+  // Sparse response matrices
+  //
+  // The migration in (mass,|y|) is near-diagonal in the flat index.
+  // SparseMigration_t accumulates only the filled (igen,ireco) pairs.
+  // The response is stored as TMatrixDSparse in the constants file
+  // (DetResponseSparse, DetResponseErrSparse) and is inverted with the
+  // banded LU decomposition BandedLU_t. Memory grows as nBins*bandwidth.
+
+  struct SparseMigrationEntry_t {
+    double w, w2;   // sum of weights and of squared weights
+    SparseMigrationEntry_t() : w(0), w2(0) {}
+  };
+  typedef std::map<int,SparseMigrationEntry_t> SparseMigrationRow_t; // key: ireco
+
+  class SparseMigration_t {
+  public:
+    SparseMigration_t(int nBins=0) : FRows(nBins) {}
+    int nBins() const { return int(FRows.size()); }
+    void fill(int igen, int ireco, double weight) {
+      SparseMigrationEntry_t &e=FRows[igen][ireco];
+      e.w += weight;
+      e.w2 += weight*weight;
+    }
+    const SparseMigrationRow_t& row(int igen) const { return FRows[igen]; }
+    int nonZeros() const;
+    void clear();
+    // migration and its error sqrt(sum w^2). The caller owns the matrices
+    void getMatrices(TMatrixDSparse **mig, TMatrixDSparse **migErr) const;
+  private:
+    std::vector<SparseMigrationRow_t> FRows;
+  };
+
+  // new sparse matrix from (irow,icol,value) triplets. The triplets may be
+  // unsorted, the values of repeated pairs are summed
+  TMatrixDSparse* makeSparseMatrix(int nRows, int nCols,
+				   const std::vector<int> &irow, const std::vector<int> &icol,
+				   const std::vector<double> &data);
+  TMatrixDSparse* denseToSparse(const TMatrixD &m); // keeps the non-zero elements
+  void sparseToDense(const TMatrixDSparse &sp, TMatrixD &m);
+  // max(i-j) and max(j-i) over the non-zero elements
+  void getBandwidth(const TMatrixDSparse &m, int &lower, int &upper);
+
+  // LU decomposition of a banded matrix with partial pivoting within
+  // the band (the upper bandwidth of U grows to lower+upper)
+  class BandedLU_t {
+  public:
+    BandedLU_t() : FN(0), FKl(0), FKu(0), FWidth(0), FA(), FL(), FPiv() {}
+    // returns 0 if the matrix is singular
+    int factorize(const TMatrixDSparse &A);
+    void solve(TVectorD &b) const;            // b := A^{-1} b
+    void solveTransposed(TVectorD &b) const;  // b := A^{-T} b
+    int size() const { return FN; }
+    int lowerBandwidth() const { return FKl; }
+    int upperBandwidth() const { return FKu; }
+  private:
+    int FN, FKl, FKu, FWidth;
+    std::vector<double> FA;   // row i holds the columns i-FKl .. i+FKl+FKu
+    std::vector<double> FL;   // FKl multipliers per elimination step
+    std::vector<int> FPiv;
+    double& a(int i, int j) { return FA[i*FWidth + j-i+FKl]; }
+    double  a(int i, int j) const { return FA[i*FWidth + j-i+FKl]; }
+  };
+
+  // Unfolding operators
+  //
+  // The unfolding matrices (and the FSR correction factors) are read once
+  // and kept in a process-wide cache keyed by the file names. An entry is
+  // reloaded when the modification time of one of its files changes. The
+  // operator acts on flat-indexed vectors, out = M*in. MSqr holds the
+  // squared elements of M for the error propagation.
+  // Files without the dense matrices are read from DetResponseSparse:
+  // out = scaleOut*(R^T)^{-1}*(scaleIn*in) is evaluated with the LU
+  // decomposition of R (scaleOut*R^T*(scaleIn*in) for the response
+  // kinds) and M is not built.
+  // The returned pointers stay valid until clearUnfoldingOperatorCache
+
+  typedef enum { _unfDetInvertedResponse=0, _unfDetResponse, _unfFsrInvertedResponse, _unfFsrResponse } TUnfoldingOperator_t;
+
+  struct UnfoldingOperator_t {
+    TUnfoldingOperator_t kind;
+    TString constFileName, correctionsFileName;
+    Long_t constModTime, correctionsModTime;
+    int status;      // result of checkBinningConsistency
+    TMatrixD M, MSqr;
+    TMatrixDSparse *R;  // sparse response, NULL for the dense operator
+    BandedLU_t *LU;     // LU of R for the inverted kinds
+    TVectorD scaleIn, scaleOut;
+
+    UnfoldingOperator_t(TUnfoldingOperator_t set_kind, const TString &constFName, const TString &corrFName) :
+      kind(set_kind), constFileName(constFName), correctionsFileName(corrFName),
+      constModTime(0), correctionsModTime(0), status(0), M(), MSqr(),
+      R(NULL), LU(NULL), scaleIn(), scaleOut() {}
+    ~UnfoldingOperator_t() { if (R) delete R; if (LU) delete LU; }
+    bool isSparse() const { return (R!=NULL); }
+    bool isInverted() const { return (kind==_unfDetInvertedResponse) || (kind==_unfFsrInvertedResponse); }
+    bool usesCorrections() const { return (kind==_unfFsrInvertedResponse) || (kind==_unfFsrResponse); }
+
+    // vout=M*vin. vin and vout may be the same vector
+    void apply(const TVectorD &vin, TVectorD &vout) const;
+    // vout_i=sqrt(sum_j (M_ij*vin_j)^2)
+    void propagateError(const TVectorD &vin, TVectorD &vout) const;
+    // the columns of vin are the input vectors
+    void applyBatch(const TMatrixD &vin, TMatrixD &vout) const;
+    void propagateErrorBatch(const TMatrixD &vin, TMatrixD &vout) const;
+  private:
+    void applySparse(const TVectorD &vin, TVectorD &vout) const;
+    void propagateErrorSparse(const TVectorD &vin, TVectorD &vout) const;
+    UnfoldingOperator_t(const UnfoldingOperator_t&);
+    UnfoldingOperator_t& operator=(const UnfoldingOperator_t&);
+  };
+
+  // returns NULL on failure, res is set to the value to be returned
+  // by the caller (see the top of the file)
+  const UnfoldingOperator_t* getUnfoldingOperator(TUnfoldingOperator_t kind,
+						  const TString &unfoldingConstFileName,
+						  const TString &correctionsFileName,
+						  int &res);
+  void clearUnfoldingOperatorCache();
+
+  // unfolding of several flat-indexed vectors (the columns of vin) at once.
+  // vout is resized to match vin
+  int  unfoldBatch(const TMatrixD &vin, TMatrixD &vout, const TString &unfoldingConstFileName);
+  int  propagateErrorThroughUnfoldingBatch(const TMatrixD &errorIn, TMatrixD &errorPropagated, const TString &unfoldingConstFileName);
+
+  // Errors on the inverse of T. The elements of T have errors
+  // (TErrPos+TErrNeg)/2. nToys>0: Monte Carlo with nToys smeared matrices,
+  // the result depends on the seed but not on nThreads. The random streams
+  // are keyed by the pair (seed,matrixIdx), thus the matrices smeared with
+  // the same seed and different matrixIdx are independent.
+  // nToys<=0: first-order error propagation
+  int calculateInvertedMatrixErrors(const TMatrixD &T,
+				    const TMatrixD &TErrPos, const TMatrixD &TErrNeg,
+				    TMatrixD &TinvErr,
+				    UInt_t seed, int nToys=10000, int nThreads=1,
+				    UInt_t matrixIdx=0);
+
   //  convert m[nMassBins][ybins] -> v[flat_idx]
   int flattenMatrix(const TMatrixD &m, TVectorD &v) {
     for (int i=0; i<DYTools::nMassBins; ++i) {
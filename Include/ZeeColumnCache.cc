@@ -0,0 +1,180 @@
+#include "../Include/ZeeColumnCache.hh"
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// --------------------------------------------------------------
+
+const char zeeColumnCacheMagic[8]="ZEECOLS";
+
+// --------------------------------------------------------------
+
+TString ZeeColumnCache_t::cacheFileName(const TString &ntupleFileName) {
+  TString fname=ntupleFileName;
+  if (fname.EndsWith(".root")) fname.Remove(fname.Length()-5);
+  fname.Append(".zcc");
+  return fname;
+}
+
+// --------------------------------------------------------------
+
+void ZeeColumnCache_t::initHeader(ZeeColumnCacheHeader_t &h, ULong64_t nEvents) {
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,zeeColumnCacheMagic,sizeof(h.magic));
+  h.version=_version;
+  h.nFloatColumns=_floatColumnCount;
+  h.nUIntColumns=_uintColumnCount;
+  h.alignment=_alignment;
+  h.nEvents=nEvents;
+}
+
+// --------------------------------------------------------------
+
+int ZeeColumnCache_t::fileStamp(const TString &fname, Long64_t &size, Long64_t &modTime) {
+  struct stat st;
+  if (stat(fname.Data(),&st)!=0) {
+    size=0; modTime=0;
+    return 0;
+  }
+  size=st.st_size;
+  modTime=st.st_mtime;
+  return 1;
+}
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
+
+int writeColumn_local(FILE *f, const void *data, ULong64_t nEvents, UInt_t elementSize) {
+  const ULong64_t size=nEvents*elementSize;
+  const ULong64_t padding=ZeeColumnCache_t::columnSize(nEvents,elementSize) - size;
+  const char zeros[ZeeColumnCache_t::_alignment]={0};
+  if (size && (fwrite(data,1,size,f)!=size)) return 0;
+  if (padding && (fwrite(zeros,1,padding,f)!=padding)) return 0;
+  return 1;
+}
+
+// --------------------------------------------------------------
+
+int ZeeColumnCacheWriter_t::close() {
+  if (!FName.Length()) {
+    std::cout << "ZeeColumnCacheWriter_t::close: file name is not set\n";
+    return 0;
+  }
+  const ULong64_t nEvents=this->size();
+  ZeeColumnCacheHeader_t h;
+  ZeeColumnCache_t::initHeader(h,nEvents);
+  if (FSourceName.Length() &&
+      !ZeeColumnCache_t::fileStamp(FSourceName,h.sourceSize,h.sourceModTime)) {
+    std::cout << "ZeeColumnCacheWriter_t::close: source file <" << FSourceName << "> does not exist\n";
+    return 0;
+  }
+
+  const TString tmpName=FName + TString(".tmp");
+  FILE *f=fopen(tmpName.Data(),"wb");
+  if (!f) {
+    std::cout << "ZeeColumnCacheWriter_t::close: failed to create <" << tmpName << ">\n";
+    return 0;
+  }
+  int ok=(fwrite(&h,sizeof(h),1,f)==1) ? 1:0;
+  for (unsigned int i=0; ok && (i<FFloatCols.size()); ++i) {
+    ok=writeColumn_local(f,(nEvents) ? &FFloatCols[i][0] : NULL,nEvents,sizeof(Float_t));
+  }
+  for (unsigned int i=0; ok && (i<FUIntCols.size()); ++i) {
+    ok=writeColumn_local(f,(nEvents) ? &FUIntCols[i][0] : NULL,nEvents,sizeof(UInt_t));
+  }
+  if (fclose(f)!=0) ok=0;
+  if (ok && (rename(tmpName.Data(),FName.Data())!=0)) ok=0;
+  if (!ok) {
+    std::cout << "ZeeColumnCacheWriter_t::close: failed to write <" << FName << ">\n";
+    remove(tmpName.Data());
+    return 0;
+  }
+  std::cout << "column cache <" << FName << "> with " << nEvents << " events saved\n";
+  this->clear();
+  return 1;
+}
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
+
+int ZeeColumnCacheReader_t::open(const TString &fname, const TString &sourceFileName) {
+  this->close();
+  FName=fname;
+  int fd=::open(fname.Data(),O_RDONLY);
+  if (fd<0) return 0;
+  struct stat st;
+  if ((fstat(fd,&st)!=0) || (ULong64_t(st.st_size)<sizeof(ZeeColumnCacheHeader_t))) {
+    ::close(fd);
+    std::cout << "ZeeColumnCacheReader_t::open: file <" << fname << "> is too short\n";
+    return 0;
+  }
+  void *ptr=mmap(NULL,st.st_size,PROT_READ,MAP_SHARED,fd,0);
+  ::close(fd);
+  if (ptr==MAP_FAILED) {
+    std::cout << "ZeeColumnCacheReader_t::open: failed to map <" << fname << ">\n";
+    return 0;
+  }
+  FMap=(char*)ptr;
+  FMapSize=st.st_size;
+
+  const ZeeColumnCacheHeader_t *h=(const ZeeColumnCacheHeader_t*)FMap;
+  const ULong64_t n=h->nEvents;
+  const ULong64_t expectedSize= sizeof(ZeeColumnCacheHeader_t) +
+    ZeeColumnCache_t::_floatColumnCount * ZeeColumnCache_t::columnSize(n,sizeof(Float_t)) +
+    ZeeColumnCache_t::_uintColumnCount * ZeeColumnCache_t::columnSize(n,sizeof(UInt_t));
+  if ((memcmp(h->magic,zeeColumnCacheMagic,sizeof(h->magic))!=0) ||
+      (h->version!=ZeeColumnCache_t::_version) ||
+      (h->nFloatColumns!=ZeeColumnCache_t::_floatColumnCount) ||
+      (h->nUIntColumns!=ZeeColumnCache_t::_uintColumnCount) ||
+      (h->alignment!=ZeeColumnCache_t::_alignment) ||
+      (FMapSize!=expectedSize)) {
+    std::cout << "ZeeColumnCacheReader_t::open: file <" << fname << "> has unexpected format\n";
+    this->close();
+    FName=fname;
+    return 0;
+  }
+
+  // the cache is valid only for the ntuple it was made from
+  Long64_t sourceSize=0, sourceModTime=0;
+  if (sourceFileName.Length()) {
+    if (!ZeeColumnCache_t::fileStamp(sourceFileName,sourceSize,sourceModTime)) {
+      std::cout << "ZeeColumnCacheReader_t::open: warning: source file <" << sourceFileName
+		<< "> is missing, <" << fname << "> is used unchecked\n";
+    }
+    else if ((h->sourceSize!=sourceSize) || (h->sourceModTime!=sourceModTime)) {
+      std::cout << "ZeeColumnCacheReader_t::open: file <" << fname
+		<< "> does not match <" << sourceFileName << ">\n";
+      this->close();
+      FName=fname;
+      return 0;
+    }
+  }
+
+  FNEvents=n;
+  const char *p=FMap + sizeof(ZeeColumnCacheHeader_t);
+  for (unsigned int i=0; i<FFloatCols.size(); ++i) {
+    FFloatCols[i]=(const Float_t*)p;
+    p+=ZeeColumnCache_t::columnSize(n,sizeof(Float_t));
+  }
+  for (unsigned int i=0; i<FUIntCols.size(); ++i) {
+    FUIntCols[i]=(const UInt_t*)p;
+    p+=ZeeColumnCache_t::columnSize(n,sizeof(UInt_t));
+  }
+  return 1;
+}
+
+// --------------------------------------------------------------
+
+void ZeeColumnCacheReader_t::close() {
+  if (FMap) munmap(FMap,FMapSize);
+  FMap=NULL;
+  FMapSize=0;
+  FNEvents=0;
+  for (unsigned int i=0; i<FFloatCols.size(); ++i) FFloatCols[i]=NULL;
+  for (unsigned int i=0; i<FUIntCols.size(); ++i) FUIntCols[i]=NULL;
+}
+
+// --------------------------------------------------------------
@@ -0,0 +1,215 @@
+#ifndef ZeeColumnCache_HH
+#define ZeeColumnCache_HH
+
+#include <TROOT.h>
+#include <TString.h>
+#include <vector>
+#include <iostream>
+#include "../Include/ZeeData.hh"
+
+// Columnar cache of the selected events
+//
+// selectEvents.C writes, next to each *_select.root ntuple, a *_select.zcc
+// file with the most used ZeeData_t quantities stored column by column as
+// plain Float_t and UInt_t arrays. The reader maps the file into memory,
+// thus the downstream macros get the columns without ROOT deserialization.
+//
+// File layout:
+//   header (ZeeColumnCacheHeader_t, 64 bytes)
+//   float columns, in the order of TFloatColumn_t
+//   uint columns, in the order of TUIntColumn_t
+// Every column starts at an offset that is a multiple of 64 bytes.
+//
+// The header keeps the size and the modification time of the ntuple.
+// The reader refuses a cache that does not match its ntuple, and
+// prepareYields.C then reads the ntuple and rebuilds the cache.
+//
+// The cache does not keep event numbers, MET, charges or trigger bits.
+// The macros that need them have to read the ROOT ntuple.
+//
+// prepareYields.C (also in the ESCALE_STUDY modes) is the only reader of
+// the selectEvents ntuples. calcEventEff.C reads its own selection file
+// with the generator mass and rapidity, subtractBackground.C reads the
+// yield matrices, and the energy scale fits read the EEM files (with
+// the .eem store of EEMStore.hh).
+
+// --------------------------------------------------------------
+
+struct ZeeColumnCacheHeader_t {
+  char magic[8];       // "ZEECOLS"
+  UInt_t version;
+  UInt_t nFloatColumns;
+  UInt_t nUIntColumns;
+  UInt_t alignment;
+  ULong64_t nEvents;
+  Long64_t sourceSize;     // size and modification time of the ntuple
+  Long64_t sourceModTime;
+  char reserved[16];
+};
+
+// --------------------------------------------------------------
+
+// read-only view of a column
+
+template<class T>
+struct ZeeColumnSpan_t {
+  const T *FData;
+  ULong64_t FSize;
+
+  ZeeColumnSpan_t(const T *set_data=NULL, ULong64_t set_size=0) :
+    FData(set_data), FSize(set_size) {}
+
+  const T* data() const { return FData; }
+  ULong64_t size() const { return FSize; }
+  const T& operator[](ULong64_t i) const { return FData[i]; }
+  const T* begin() const { return FData; }
+  const T* end() const { return FData+FSize; }
+};
+
+// --------------------------------------------------------------
+
+class ZeeColumnCache_t {
+public:
+  typedef enum { _mass=0, _pt, _y, _phi,
+		 _pt_1, _eta_1, _phi_1, _scEt_1, _scEta_1,
+		 _pt_2, _eta_2, _phi_2, _scEt_2, _scEta_2,
+		 _weight, _floatColumnCount } TFloatColumn_t;
+  typedef enum { _runNum=0, _nPV, _nGoodPV,
+		 _uintColumnCount } TUIntColumn_t;
+  typedef enum { _version=2, _alignment=64 } TConst_t;
+
+  static TString cacheFileName(const TString &ntupleFileName);
+  static void initHeader(ZeeColumnCacheHeader_t &h, ULong64_t nEvents);
+  // size and modification time of a file. Returns 0 if it does not exist
+  static int fileStamp(const TString &fname, Long64_t &size, Long64_t &modTime);
+  static ULong64_t columnSize(ULong64_t nEvents, UInt_t elementSize) {
+    ULong64_t size=nEvents*elementSize;
+    return ((size+_alignment-1)/_alignment)*_alignment;
+  }
+};
+
+// --------------------------------------------------------------
+
+// Accumulates the columns in memory and writes them on close()
+
+class ZeeColumnCacheWriter_t {
+protected:
+  TString FName, FSourceName;
+  std::vector<std::vector<Float_t> > FFloatCols;
+  std::vector<std::vector<UInt_t> > FUIntCols;
+public:
+  ZeeColumnCacheWriter_t(const TString &set_fname="", const TString &set_sourceName="") :
+    FName(set_fname), FSourceName(set_sourceName),
+    FFloatCols(ZeeColumnCache_t::_floatColumnCount),
+    FUIntCols(ZeeColumnCache_t::_uintColumnCount)
+  {}
+
+  const TString& fileName() const { return FName; }
+  void setFileName(const TString &set_fname) { FName=set_fname; }
+  // the ntuple with the same events. It has to be closed before close()
+  const TString& sourceFileName() const { return FSourceName; }
+  void setSourceFileName(const TString &set_sourceName) { FSourceName=set_sourceName; }
+  ULong64_t size() const { return FFloatCols[0].size(); }
+
+  void reserve(ULong64_t n) {
+    for (unsigned int i=0; i<FFloatCols.size(); ++i) FFloatCols[i].reserve(n);
+    for (unsigned int i=0; i<FUIntCols.size(); ++i) FUIntCols[i].reserve(n);
+  }
+
+  void clear() {
+    for (unsigned int i=0; i<FFloatCols.size(); ++i) FFloatCols[i].clear();
+    for (unsigned int i=0; i<FUIntCols.size(); ++i) FUIntCols[i].clear();
+  }
+
+  // works with ZeeData_t and with the plain ZeeData structure
+  template<class ZeeData_type>
+  void add(const ZeeData_type &d) {
+    FFloatCols[ZeeColumnCache_t::_mass   ].push_back(d.mass);
+    FFloatCols[ZeeColumnCache_t::_pt     ].push_back(d.pt);
+    FFloatCols[ZeeColumnCache_t::_y      ].push_back(d.y);
+    FFloatCols[ZeeColumnCache_t::_phi    ].push_back(d.phi);
+    FFloatCols[ZeeColumnCache_t::_pt_1   ].push_back(d.pt_1);
+    FFloatCols[ZeeColumnCache_t::_eta_1  ].push_back(d.eta_1);
+    FFloatCols[ZeeColumnCache_t::_phi_1  ].push_back(d.phi_1);
+    FFloatCols[ZeeColumnCache_t::_scEt_1 ].push_back(d.scEt_1);
+    FFloatCols[ZeeColumnCache_t::_scEta_1].push_back(d.scEta_1);
+    FFloatCols[ZeeColumnCache_t::_pt_2   ].push_back(d.pt_2);
+    FFloatCols[ZeeColumnCache_t::_eta_2  ].push_back(d.eta_2);
+    FFloatCols[ZeeColumnCache_t::_phi_2  ].push_back(d.phi_2);
+    FFloatCols[ZeeColumnCache_t::_scEt_2 ].push_back(d.scEt_2);
+    FFloatCols[ZeeColumnCache_t::_scEta_2].push_back(d.scEta_2);
+    FFloatCols[ZeeColumnCache_t::_weight ].push_back(d.weight);
+    FUIntCols[ZeeColumnCache_t::_runNum  ].push_back(d.runNum);
+    FUIntCols[ZeeColumnCache_t::_nPV     ].push_back(d.nPV);
+    FUIntCols[ZeeColumnCache_t::_nGoodPV ].push_back(d.nGoodPV);
+  }
+
+  // writes the file (via a temporary file, renamed when complete)
+  int close();
+};
+
+// --------------------------------------------------------------
+
+// Maps a cache file into memory. The spans are valid while the reader
+// is open
+
+class ZeeColumnCacheReader_t {
+protected:
+  TString FName;
+  char *FMap;
+  ULong64_t FMapSize;
+  ULong64_t FNEvents;
+  std::vector<const Float_t*> FFloatCols;
+  std::vector<const UInt_t*> FUIntCols;
+public:
+  ZeeColumnCacheReader_t() :
+    FName(), FMap(NULL), FMapSize(0), FNEvents(0),
+    FFloatCols(ZeeColumnCache_t::_floatColumnCount,(const Float_t*)NULL),
+    FUIntCols(ZeeColumnCache_t::_uintColumnCount,(const UInt_t*)NULL)
+  {}
+  ~ZeeColumnCacheReader_t() { this->close(); }
+
+  // returns 1 on success, 0 if the file is missing or not valid.
+  // If sourceFileName is given, the cache has to match that ntuple.
+  // A missing source file gives a warning only
+  int open(const TString &fname, const TString &sourceFileName="");
+  void close();
+
+  int isOpen() const { return (FMap) ? 1:0; }
+  const TString& fileName() const { return FName; }
+  ULong64_t size() const { return FNEvents; }
+
+  ZeeColumnSpan_t<Float_t> column(ZeeColumnCache_t::TFloatColumn_t col) const {
+    return ZeeColumnSpan_t<Float_t>(FFloatCols[col],FNEvents);
+  }
+  ZeeColumnSpan_t<UInt_t> column(ZeeColumnCache_t::TUIntColumn_t col) const {
+    return ZeeColumnSpan_t<UInt_t>(FUIntCols[col],FNEvents);
+  }
+
+  // fills the cached fields of ZeeData_t. The other fields are not touched
+  template<class ZeeData_type>
+  void getEntry(ULong64_t i, ZeeData_type &d) const {
+    d.mass   = FFloatCols[ZeeColumnCache_t::_mass   ][i];
+    d.pt     = FFloatCols[ZeeColumnCache_t::_pt     ][i];
+    d.y      = FFloatCols[ZeeColumnCache_t::_y      ][i];
+    d.phi    = FFloatCols[ZeeColumnCache_t::_phi    ][i];
+    d.pt_1   = FFloatCols[ZeeColumnCache_t::_pt_1   ][i];
+    d.eta_1  = FFloatCols[ZeeColumnCache_t::_eta_1  ][i];
+    d.phi_1  = FFloatCols[ZeeColumnCache_t::_phi_1  ][i];
+    d.scEt_1 = FFloatCols[ZeeColumnCache_t::_scEt_1 ][i];
+    d.scEta_1= FFloatCols[ZeeColumnCache_t::_scEta_1][i];
+    d.pt_2   = FFloatCols[ZeeColumnCache_t::_pt_2   ][i];
+    d.eta_2  = FFloatCols[ZeeColumnCache_t::_eta_2  ][i];
+    d.phi_2  = FFloatCols[ZeeColumnCache_t::_phi_2  ][i];
+    d.scEt_2 = FFloatCols[ZeeColumnCache_t::_scEt_2 ][i];
+    d.scEta_2= FFloatCols[ZeeColumnCache_t::_scEta_2][i];
+    d.weight = FFloatCols[ZeeColumnCache_t::_weight ][i];
+    d.runNum = FUIntCols[ZeeColumnCache_t::_runNum  ][i];
+    d.nPV    = FUIntCols[ZeeColumnCache_t::_nPV     ][i];
+    d.nGoodPV= FUIntCols[ZeeColumnCache_t::_nGoodPV ][i];
+  }
+};
+
+// --------------------------------------------------------------
+
+#endif
@@ -10,7 +10,9 @@
 #include "DYTools.hh"
 #include "DYToolsUI.hh"
 #include "EleIDCuts.hh"
+#include "EleIDKernels.hh"
 #include "TriggerSelection.hh"
+#include <TClonesArray.h>
 
 #endif
 
@@ -24,5 +26,12 @@ bool passID(const mithep::TElectron *electron, double rho);
 
 bool isTag(const mithep::TElectron *electron, ULong_t trigger, double rho);
 
+// ID (and tag ID) of both legs of all dielectrons of the event. The bits
+// 2*i and 2*i+1 correspond to the legs of the dielectron i
+void evaluateLegIDs(const TClonesArray *dielectronArr, double rho, EleIDBatch_t &batch, std::vector<UInt_t> &idBits, std::vector<UInt_t> *tagIDBits=NULL);
+
+// leg=1,2. legPassesIDTag is the tag ID bit of the leg
+bool isTag(const mithep::TDielectron *dielectron, int leg, bool legPassesIDTag, ULong_t trigger);
+
 TString getLabel(int sample, DYTools::TEfficiencyKind_t effType, int method, DYTools::TEtBinSet_t etBinning, DYTools::TEtaBinSet_t etaBinning, const TriggerSelection &trigSet);
 
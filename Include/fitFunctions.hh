@@ -17,6 +17,11 @@
 
 #endif
 
+// binned probes, see EventScaleFactors/tnpProbeStore.hh. If the store
+// is given, the efficiency is measured from its slices and the trees
+// are not used
+class tnpProbeStore_t;
+
 //void measurePassAndFail(double &signal, double &signalErr, 
 // double &efficiency, double &efficiencyErr,
 // TTree *passTree, TTree *failTree,TCanvas *passCanvas, TCanvas *failCanvas,
@@ -30,7 +35,9 @@ void measureEfficiency(TTree *passTree, TTree *failTree,
 		       int NsetBins, DYTools::TEfficiencyKind_t effType, 
 		       const char* setBinsType, 
 		       TString dirTag, const TString &picFileExtraTag, 
-		       int puBin=-1); // puBin is important for the fit
+		       int puBin=-1, // puBin is important for the fit
+		       const tnpProbeStore_t *store=NULL,
+		       int nParallelFits=4);
 
 void measureEfficiencyPU(TTree *passTreeFull, TTree *failTreeFull, 
 		 int method, int etBinning, int etaBinning, TCanvas *canvas, 
@@ -40,14 +47,16 @@ void measureEfficiencyPU(TTree *passTreeFull, TTree *failTreeFull,
 			 int NsetBins, DYTools::TEfficiencyKind_t effType,
 			 const char* setBinsType, 
 			 TString dirTag, const TString &picFileExtraTag, 
-			 int puDependence=0);
+			 int puDependence=0, const tnpProbeStore_t *store=NULL,
+			 int nParallelFits=4);
 
 void measureEfficiencyCountAndCount(TTree *passTree, TTree *failTree, 
 			    int etBinning, int etaBinning, 
 			    TCanvas *canvas, ofstream &effOutput, 
 			    bool saveResultsToRootFile, TFile *resultsRootFile,
 				    TFile *plotsRootFile, 
-				    DYTools::TEfficiencyKind_t effType);
+				    DYTools::TEfficiencyKind_t effType,
+				    int puBin=-1, const tnpProbeStore_t *store=NULL);
 
 void measureEfficiencyWithFit(TTree *passTree, TTree *failTree, 
 			      int method, int etBinning, int etaBinning, TCanvas *canvas, 
@@ -56,7 +65,9 @@ void measureEfficiencyWithFit(TTree *passTree, TTree *failTree,
 			      TFile *resultsRootFile, TFile *plotsRootFile,
 			      int NsetBins, DYTools::TEfficiencyKind_t effType,
 			      const char* setBinsType,
-			      TString dirTag, const TString &picFileExtraTag, int puBin=-1);
+			      TString dirTag, const TString &picFileExtraTag, int puBin=-1,
+			      const tnpProbeStore_t *store=NULL,
+			      int nParallelFits=4); // bins fitted at a time
 
 int getTemplateBin(int etBin, int etaBin, int etaBinning);
 
@@ -57,11 +57,19 @@ enum BackgroundFitPDFType {EXPONENTIAL,
 
 void printCorrelations(ostream& os, RooFitResult *res);
 
+// The trees given to fitMass and fitMassWithTemplates may already
+// contain only the probes of the bin. Then applyCut=false, and the cut
+// string is used only to label the fit
+RooDataSet* newTnPDataSet(const char *name, TTree *tree, 
+			  const RooArgSet &vars, const RooFormulaVar &rooCut,
+			  bool applyCut, const char *wgtVarName=0);
+
 void fitMass(TTree *passTree, TTree *failTree, TString cut, int mode, 
      double &efficiency, double &efficiencyErrHigh, double &efficiencyErrLow, 
 	     TPad *passPad, TPad *failPad, TFile *plotsRootFile,
 	     ofstream &fitLog, int NsetBins, 
-	     bool isRECO, const char* setBinsType, TString dirTag);
+	     bool isRECO, const char* setBinsType, TString dirTag,
+	     bool applyCut=true);
 
 void fitMassWithTemplates(TTree *passTree, TTree *failTree, TString cut, 
 			  int mode, 
@@ -71,6 +79,7 @@ void fitMassWithTemplates(TTree *passTree, TTree *failTree, TString cut,
 			  ofstream &fitLog, 
 			  TH1F *templatePass, TH1F *templateFail, 
 			  bool isRECO, const char* setBinsType, 
-			  TString dirTag, const TString &picFileExtraTag );
+			  TString dirTag, const TString &picFileExtraTag,
+			  bool applyCut=true);
 
 #endif
@@ -0,0 +1,447 @@
+#include "SkimEngine.hh"
+#include <TChain.h>
+#include <TThread.h>
+#include <TMutex.h>
+#include <TSystem.h>
+#include <assert.h>
+
+#include "../Include/TElectron.hh"
+#include "../Include/TDielectron.hh"
+#include "../Include/TMuon.hh"
+#include "../Include/TPhoton.hh"
+#include "../Include/TJet.hh"
+#include "../Include/TVertex.hh"
+#include "../Include/DYTools.hh"
+#include "../Include/EleIDCuts.hh"
+#include "../Include/InputFileMgr.hh"
+
+// --------------------------------------------------------------
+
+// TFile opening and closing is serialized between the workers
+TMutex skimFileMutex;
+// protects the file counter of the engine
+TMutex skimJobMutex;
+
+const int skimBranchCount=8;
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
+
+SkimEvent_t::SkimEvent_t() :
+  info(new mithep::TEventInfo()),
+  gen(new mithep::TGenInfo()),
+  electronArr(new TClonesArray("mithep::TElectron")),
+  dielectronArr(new TClonesArray("mithep::TDielectron")),
+  muonArr(new TClonesArray("mithep::TMuon")),
+  pfJetArr(new TClonesArray("mithep::TJet")),
+  photonArr(new TClonesArray("mithep::TPhoton")),
+  pvArr(new TClonesArray("mithep::TVertex"))
+{}
+
+// --------------------------------------------------------------
+
+SkimEvent_t::~SkimEvent_t() {
+  delete info;
+  delete gen;
+  delete electronArr;
+  delete dielectronArr;
+  delete muonArr;
+  delete pfJetArr;
+  delete photonArr;
+  delete pvArr;
+}
+
+// --------------------------------------------------------------
+
+void** SkimEvent_t::address(TSkimBranch_t br) {
+  switch(br) {
+  case _skimInfo: return (void**)&info;
+  case _skimGen: return (void**)&gen;
+  case _skimElectron: return (void**)&electronArr;
+  case _skimDielectron: return (void**)&dielectronArr;
+  case _skimMuon: return (void**)&muonArr;
+  case _skimPFJet: return (void**)&pfJetArr;
+  case _skimPhoton: return (void**)&photonArr;
+  case _skimPV: return (void**)&pvArr;
+  default: ;
+  }
+  std::cout << "SkimEvent_t::address: unknown branch " << int(br) << "\n";
+  assert(0);
+  return NULL;
+}
+
+// --------------------------------------------------------------
+
+void SkimEvent_t::clearArrays() {
+  electronArr->Clear();
+  dielectronArr->Clear();
+  muonArr->Clear();
+  pfJetArr->Clear();
+  photonArr->Clear();
+  pvArr->Clear();
+}
+
+// --------------------------------------------------------------
+
+const char* SkimEvent_t::branchName(TSkimBranch_t br) {
+  switch(br) {
+  case _skimInfo: return "Info";
+  case _skimGen: return "Gen";
+  case _skimElectron: return "Electron";
+  case _skimDielectron: return "Dielectron";
+  case _skimMuon: return "Muon";
+  case _skimPFJet: return "PFJet";
+  case _skimPhoton: return "Photon";
+  case _skimPV: return "PV";
+  default: ;
+  }
+  return "unknown";
+}
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
+
+Bool_t SkimDielectronPredicate_t::keep(const SkimEvent_t &ev) {
+  const TClonesArray *dielectronArr=ev.dielectronArr;
+  const double rho=ev.info->rhoLowEta;
+  FBatch.clear();
+  for(Int_t i=0; i<dielectronArr->GetEntriesFast(); i++) {
+    const mithep::TDielectron *dielectron = (const mithep::TDielectron*)(dielectronArr->At(i));
+    // Require at least one dielectron above 19 GeV and the other above 9 GeV
+    if( !((dielectron->scEt_1 > 19 && dielectron->scEt_2 > 9) ||
+	  (dielectron->scEt_1 > 9 && dielectron->scEt_2 > 19)) ) continue;
+    FBatch.addLegs(dielectron,rho);
+  }
+  if (!FBatch.size()) return kFALSE;
+  // Require one (or both) of the electrons to pass full ID
+  if( DYTools::energy8TeV == 1 ) EGMIDKernel_t<EGM2012,WP_MEDIUM>::evaluate(FBatch,FBits);
+  else EGMIDKernel_t<EGM2011,WP_MEDIUM>::evaluate(FBatch,FBits);
+  for (unsigned int k=0; k<FBatch.size(); k+=2) {
+    const int pass1=EleIDBatch_t::testBit(FBits,k);
+    const int pass2=EleIDBatch_t::testBit(FBits,k+1);
+    const Bool_t idCut=(FRequireBoth) ? (pass1 && pass2) : (pass1 || pass2);
+    if (idCut) return kTRUE;
+  }
+  return kFALSE;
+}
+
+// --------------------------------------------------------------
+
+void SkimDielectronPredicate_t::describe(std::vector<std::string> &lines) const {
+  lines.push_back("# Skim: dielectron with scEt>19 and scEt>9 GeV");
+  lines.push_back((FRequireBoth) ?
+		  "# Skim: both electrons pass EGM ID WP_MEDIUM" :
+		  "# Skim: at least one electron passes EGM ID WP_MEDIUM");
+}
+
+// --------------------------------------------------------------
+
+void SkimGenMassPredicate_t::describe(std::vector<std::string> &lines) const {
+  lines.push_back(Form("# Trim: generator level mass in [%g,%g)",FMassMin,FMassMax));
+}
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
+
+SkimWorker_t::SkimWorker_t(SkimEngine_t *engine, const SkimPredicate_t &pred) :
+  FEngine(engine),
+  FPredicate(pred.clone()),
+  FEvent(),
+  FStatus(1)
+{}
+
+// --------------------------------------------------------------
+
+void SkimWorker_t::run() {
+  int ifile;
+  while (FStatus && ((ifile=FEngine->takeFile())>=0)) {
+    if (!this->processFile(UInt_t(ifile))) FStatus=0;
+  }
+}
+
+// --------------------------------------------------------------
+
+int SkimWorker_t::processFile(UInt_t ifile) {
+  const TString &inFileName=FEngine->FInFileNames[ifile];
+  const TString &partFileName=FEngine->FPartFileNames[ifile];
+  const UInt_t predicateMask=FPredicate->inputBranches();
+  // the branches written also for the rejected events are read for every event
+  const UInt_t alwaysMask=(FEngine->FKeepRejected) ?
+    (FEngine->FOutputBranches & (_skimInfo | _skimGen) & (~predicateMask)) : 0;
+  const UInt_t fetchMask=FEngine->FFetchBranches & FEngine->FOutputBranches & (~predicateMask) & (~alwaysMask);
+
+  TFile *infile=NULL, *outfile=NULL;
+  TTree *eventTree=NULL, *outTree=NULL;
+  TBranch *predicateBr[skimBranchCount];
+  TBranch *fetchBr[skimBranchCount];
+  TBranch *alwaysBr[skimBranchCount];
+  int nPredicateBr=0, nFetchBr=0, nAlwaysBr=0;
+  ULong64_t origNumEntries=0;
+  {
+    TLockGuard lock(&skimFileMutex);
+    std::cout << "Skimming " << inFileName << "..." << std::endl;
+    TDirectory *saveDir=gDirectory;
+    infile=new TFile(inFileName);
+    if (!infile || !infile->IsOpen()) {
+      std::cout << "SkimWorker: failed to open <" << inFileName << ">\n";
+      saveDir->cd();
+      return 0;
+    }
+    eventTree=(TTree*)infile->Get("Events");
+    if (!eventTree) {
+      std::cout << "SkimWorker: no Events tree in <" << inFileName << ">\n";
+      delete infile;
+      saveDir->cd();
+      return 0;
+    }
+    origNumEntries=eventTree->GetEntries();
+    TTree *descrTree=(TTree*)infile->Get("Description");
+    if (descrTree && descrTree->GetBranch("origNumEntries")) {
+      UInt_t n=0;
+      descrTree->SetBranchAddress("origNumEntries",&n);
+      descrTree->GetBranch("origNumEntries")->GetEntry(0);
+      if (n>0) origNumEntries=n;
+    }
+
+    for (int ib=0; ib<skimBranchCount; ++ib) {
+      const TSkimBranch_t br=TSkimBranch_t(1<<ib);
+      const int inPredicate=(predicateMask & br) ? 1:0;
+      const int inFetch=(fetchMask & br) ? 1:0;
+      const int inAlways=(alwaysMask & br) ? 1:0;
+      if (!inPredicate && !inFetch && !inAlways) continue;
+      const char *name=SkimEvent_t::branchName(br);
+      TBranch *b=eventTree->GetBranch(name);
+      if (!b) {
+	std::cout << "SkimWorker: branch " << name << " is not found in <" << inFileName << ">\n";
+	delete infile;
+	saveDir->cd();
+	return 0;
+      }
+      eventTree->SetBranchAddress(name,FEvent.address(br));
+      if (inPredicate) predicateBr[nPredicateBr++]=b;
+      else if (inAlways) alwaysBr[nAlwaysBr++]=b;
+      else fetchBr[nFetchBr++]=b;
+    }
+
+    outfile=new TFile(partFileName,"RECREATE");
+    if (!outfile || !outfile->IsOpen()) {
+      std::cout << "SkimWorker: failed to create <" << partFileName << ">\n";
+      delete infile;
+      saveDir->cd();
+      return 0;
+    }
+    outfile->cd();
+    outTree=new TTree("Events","Events");
+    if (FEngine->FOutputBranches & _skimInfo)       outTree->Branch("Info",       &FEvent.info);
+    if (FEngine->FOutputBranches & _skimGen)        outTree->Branch("Gen",        &FEvent.gen);
+    if (FEngine->FOutputBranches & _skimElectron)   outTree->Branch("Electron",   &FEvent.electronArr);
+    if (FEngine->FOutputBranches & _skimDielectron) outTree->Branch("Dielectron", &FEvent.dielectronArr);
+    if (FEngine->FOutputBranches & _skimMuon)       outTree->Branch("Muon",       &FEvent.muonArr);
+    if (FEngine->FOutputBranches & _skimPFJet)      outTree->Branch("PFJet",      &FEvent.pfJetArr);
+    if (FEngine->FOutputBranches & _skimPhoton)     outTree->Branch("Photon",     &FEvent.photonArr);
+    if (FEngine->FOutputBranches & _skimPV)         outTree->Branch("PV",         &FEvent.pvArr);
+    saveDir->cd();
+  }
+
+  // The arrays that are neither read for the decision nor fetched are
+  // never filled, thus they are written empty
+  const ULong64_t nEntries=eventTree->GetEntries();
+  ULong64_t nPass=0;
+  for (ULong64_t ientry=0; ientry<nEntries; ++ientry) {
+    for (int ib=0; ib<nPredicateBr; ++ib) predicateBr[ib]->GetEntry(ientry);
+    if (!FPredicate->keep(FEvent)) {
+      if (!FEngine->FKeepRejected) continue;
+      for (int ib=0; ib<nAlwaysBr; ++ib) alwaysBr[ib]->GetEntry(ientry);
+      FEvent.clearArrays();
+      outTree->Fill();
+      continue;
+    }
+    for (int ib=0; ib<nAlwaysBr; ++ib) alwaysBr[ib]->GetEntry(ientry);
+    for (int ib=0; ib<nFetchBr; ++ib) fetchBr[ib]->GetEntry(ientry);
+    outTree->Fill();
+    nPass++;
+  }
+
+  {
+    TLockGuard lock(&skimFileMutex);
+    outfile->WriteTObject(outTree);
+    delete outfile;
+    delete infile;
+  }
+  FEngine->FInputEvts[ifile]=nEntries;
+  FEngine->FPassEvts[ifile]=nPass;
+  FEngine->FOrigNumEntries[ifile]=origNumEntries;
+  std::cout << "  " << inFileName << ": " << nPass << " of " << nEntries << " events passed" << std::endl;
+  return 1;
+}
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
+
+void* skimWorkerThread(void *arg) {
+  SkimWorker_t *worker=(SkimWorker_t*)arg;
+  worker->run();
+  return NULL;
+}
+
+// --------------------------------------------------------------
+// --------------------------------------------------------------
+
+SkimEngine_t::SkimEngine_t(const SkimPredicate_t &pred, UInt_t outputBranches, UInt_t fetchBranches, Bool_t writeOrigNumEntries, Bool_t keepRejected) :
+  FPredicate(pred),
+  FOutputBranches(outputBranches),
+  FFetchBranches(fetchBranches),
+  FWriteOrigNumEntries(writeOrigNumEntries),
+  FKeepRejected(keepRejected),
+  FInFileNames(), FPartFileNames(),
+  FInputEvts(), FPassEvts(), FOrigNumEntries(),
+  FNextFile(0)
+{}
+
+// --------------------------------------------------------------
+
+ULong64_t SkimEngine_t::inputEvents() const {
+  ULong64_t n=0;
+  for (unsigned int i=0; i<FInputEvts.size(); ++i) n+=FInputEvts[i];
+  return n;
+}
+
+// --------------------------------------------------------------
+
+ULong64_t SkimEngine_t::passedEvents() const {
+  ULong64_t n=0;
+  for (unsigned int i=0; i<FPassEvts.size(); ++i) n+=FPassEvts[i];
+  return n;
+}
+
+// --------------------------------------------------------------
+
+int SkimEngine_t::takeFile() {
+  TLockGuard lock(&skimJobMutex);
+  if (FNextFile>=FInFileNames.size()) return -1;
+  return int(FNextFile++);
+}
+
+// --------------------------------------------------------------
+
+int SkimEngine_t::run(const std::vector<TString> &inFileNames, const TString &outFileName, int nWorkers, const std::vector<std::string> *description) {
+  TTree::SetMaxTreeSize(kMaxLong64);
+
+  // Don't write TObject part of the objects
+  mithep::TEventInfo::Class()->IgnoreTObjectStreamer();
+  mithep::TGenInfo::Class()->IgnoreTObjectStreamer();
+  mithep::TElectron::Class()->IgnoreTObjectStreamer();
+  mithep::TDielectron::Class()->IgnoreTObjectStreamer();
+  mithep::TMuon::Class()->IgnoreTObjectStreamer();
+  mithep::TJet::Class()->IgnoreTObjectStreamer();
+  mithep::TPhoton::Class()->IgnoreTObjectStreamer();
+  mithep::TVertex::Class()->IgnoreTObjectStreamer();
+
+  if (inFileNames.size()==0) {
+    std::cout << "SkimEngine_t::run: no input files\n";
+    return 0;
+  }
+  FInFileNames=inFileNames;
+  FPartFileNames.clear();
+  TString base=outFileName;
+  if (base.EndsWith(".root")) base.Remove(base.Length()-5);
+  for (unsigned int i=0; i<FInFileNames.size(); ++i) {
+    FPartFileNames.push_back(base + TString(Form("_part%d.root",i)));
+  }
+  FInputEvts.assign(FInFileNames.size(),0);
+  FPassEvts.assign(FInFileNames.size(),0);
+  FOrigNumEntries.assign(FInFileNames.size(),0);
+  FNextFile=0;
+
+  if (nWorkers<1) nWorkers=1;
+  if (nWorkers>int(FInFileNames.size())) nWorkers=FInFileNames.size();
+  if (nWorkers>1) TThread::Initialize();
+
+  std::vector<SkimWorker_t*> workers;
+  for (int i=0; i<nWorkers; ++i) workers.push_back(new SkimWorker_t(this,FPredicate));
+  if (nWorkers==1) {
+    workers[0]->run();
+  }
+  else {
+    std::vector<TThread*> threads;
+    for (int i=0; i<nWorkers; ++i) {
+      threads.push_back(new TThread(Form("skimWorker_%d",i),
+				    skimWorkerThread, (void*)workers[i]));
+      threads.back()->Run();
+    }
+    for (int i=0; i<nWorkers; ++i) {
+      threads[i]->Join();
+      delete threads[i];
+    }
+  }
+  int ok=1;
+  for (int i=0; i<nWorkers; ++i) {
+    if (!workers[i]->status()) ok=0;
+    delete workers[i];
+  }
+  if (ok) ok=this->mergeParts(outFileName,description);
+  for (unsigned int i=0; i<FPartFileNames.size(); ++i) {
+    gSystem->Unlink(FPartFileNames[i]);
+  }
+  if (!ok) std::cout << "SkimEngine_t::run: failed to create " << outFileName << "\n";
+  return ok;
+}
+
+// --------------------------------------------------------------
+
+int SkimEngine_t::mergeParts(const TString &outFileName, const std::vector<std::string> *description) {
+  ULong64_t origNumEntriesSum=0;
+  for (unsigned int i=0; i<FOrigNumEntries.size(); ++i) origNumEntriesSum+=FOrigNumEntries[i];
+  UInt_t origNumEntries=(FWriteOrigNumEntries) ? UInt_t(origNumEntriesSum) : 0;
+
+  TDescriptiveInfo_t *descr=new TDescriptiveInfo_t();
+  std::vector<std::string> *lines=&descr->_info;
+  for (unsigned int i=0; i<FInFileNames.size(); ++i) {
+    lines->push_back(std::string("# Initial file: ") + std::string(FInFileNames[i].Data()));
+  }
+  FPredicate.describe(*lines);
+  if (description) lines->insert(lines->end(),description->begin(),description->end());
+
+  TFile *outfile=new TFile(outFileName,"RECREATE");
+  if (!outfile || !outfile->IsOpen()) {
+    std::cout << "SkimEngine_t::mergeParts: failed to create <" << outFileName << ">\n";
+    delete descr;
+    return 0;
+  }
+  outfile->cd();
+  TTree *descriptionTree = new TTree("Description","description");
+  descriptionTree->Branch("description","TDescriptiveInfo_t",&descr);
+  descriptionTree->Branch("origNumEntries",&origNumEntries,"origNumEntries/i",sizeof(origNumEntries));
+  descriptionTree->Fill();
+  descriptionTree->Write();
+
+  // with keepRejected every input event is written
+  const ULong64_t writtenEvents=(FKeepRejected) ? this->inputEvents() : this->passedEvents();
+  Long64_t res=0;
+  if (writtenEvents==0) {
+    // nothing to merge, keep the structure of the tree
+    TFile part(FPartFileNames[0]);
+    TTree *partTree=(TTree*)part.Get("Events");
+    if (partTree) {
+      outfile->cd();
+      TTree *emptyTree=partTree->CloneTree(0);
+      emptyTree->Write();
+      res=1;
+    }
+  }
+  else {
+    // the baskets are copied without decompression
+    TChain chain("Events");
+    for (unsigned int i=0; i<FPartFileNames.size(); ++i) chain.Add(FPartFileNames[i]);
+    res=chain.Merge(outfile,0,"fast keep");
+  }
+  delete outfile;
+  delete descr;
+  if (res<=0) {
+    std::cout << "SkimEngine_t::mergeParts: failed to merge the Events trees\n";
+    return 0;
+  }
+  return 1;
+}
+
+// --------------------------------------------------------------
@@ -0,0 +1,159 @@
+#ifndef SkimEngine_HH
+#define SkimEngine_HH
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TClonesArray.h>
+#include <TString.h>
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "../Include/TEventInfo.hh"
+#include "../Include/TGenInfo.hh"
+#include "../Include/EleIDKernels.hh"
+
+// Skimming of the ntuples
+//
+// The skim decision is made by a SkimPredicate_t. The predicate declares
+// the branches it needs, and only these branches are read for every
+// event. The remaining branches of the output (SkimEngine_t fetch mask)
+// are read for the accepted events only, and only the accepted events
+// are written. The branches that are neither needed by the predicate
+// nor fetched are written as empty arrays.
+// With keepRejected (signal MC), the rejected events are written as well,
+// with Info and Gen and empty arrays, so that the generator level
+// denominators of the acceptance, FSR and unfolding see every event.
+//
+// The input files are processed by SkimWorker_t objects, one input file
+// at a time, either in the main thread (nWorkers=1) or in separate
+// threads. Every input file gives a temporary output file, and the
+// temporary files are merged in the order of the input files. The
+// output file has a Description tree with origNumEntries, the total
+// number of the input entries (AdjustXSectionForSkim rescales the
+// cross section by the fraction of the accepted events). If an input
+// file has a Description tree itself, its origNumEntries is used
+
+// --------------------------------------------------------------
+
+typedef enum { _skimInfo=1, _skimGen=2, _skimElectron=4, _skimDielectron=8,
+	       _skimMuon=16, _skimPFJet=32, _skimPhoton=64, _skimPV=128,
+	       _skimAllBranches=255 } TSkimBranch_t;
+
+// --------------------------------------------------------------
+
+struct SkimEvent_t {
+  mithep::TEventInfo *info;
+  mithep::TGenInfo *gen;
+  TClonesArray *electronArr, *dielectronArr, *muonArr;
+  TClonesArray *pfJetArr, *photonArr, *pvArr;
+
+  SkimEvent_t();
+  ~SkimEvent_t();
+  // the object of the branch
+  void** address(TSkimBranch_t br);
+  void clearArrays();
+  static const char* branchName(TSkimBranch_t br);
+};
+
+// --------------------------------------------------------------
+
+class SkimPredicate_t {
+public:
+  virtual ~SkimPredicate_t() {}
+  // each worker gets its own copy
+  virtual SkimPredicate_t* clone() const = 0;
+  // mask of TSkimBranch_t needed for the decision
+  virtual UInt_t inputBranches() const = 0;
+  virtual Bool_t keep(const SkimEvent_t &ev) = 0;
+  virtual void describe(std::vector<std::string> &lines) const = 0;
+};
+
+// --------------------------------------------------------------
+
+// at least one dielectron with Et>19,9 GeV, and one (or both) of its
+// electrons pass the EGM medium ID. The legs of the dielectrons passing
+// the Et cut are collected in a batch and evaluated at once
+class SkimDielectronPredicate_t : public SkimPredicate_t {
+protected:
+  Bool_t FRequireBoth;
+  EleIDBatch_t FBatch;
+  std::vector<UInt_t> FBits;
+public:
+  SkimDielectronPredicate_t(Bool_t requireBoth) : SkimPredicate_t(), FRequireBoth(requireBoth), FBatch(), FBits() {}
+  SkimPredicate_t* clone() const { return new SkimDielectronPredicate_t(*this); }
+  UInt_t inputBranches() const { return _skimInfo | _skimDielectron; }
+  Bool_t keep(const SkimEvent_t &ev);
+  void describe(std::vector<std::string> &lines) const;
+};
+
+// --------------------------------------------------------------
+
+// generator level mass in [massMin,massMax)
+class SkimGenMassPredicate_t : public SkimPredicate_t {
+protected:
+  double FMassMin, FMassMax;
+public:
+  SkimGenMassPredicate_t(double massMin, double massMax) : SkimPredicate_t(), FMassMin(massMin), FMassMax(massMax) {}
+  SkimPredicate_t* clone() const { return new SkimGenMassPredicate_t(*this); }
+  UInt_t inputBranches() const { return _skimGen; }
+  Bool_t keep(const SkimEvent_t &ev) { return ((ev.gen->vmass>=FMassMin) && (ev.gen->vmass<FMassMax)) ? kTRUE : kFALSE; }
+  void describe(std::vector<std::string> &lines) const;
+};
+
+// --------------------------------------------------------------
+
+class SkimEngine_t;
+
+class SkimWorker_t {
+protected:
+  SkimEngine_t *FEngine;
+  SkimPredicate_t *FPredicate;
+  SkimEvent_t FEvent;
+  int FStatus;
+public:
+  SkimWorker_t(SkimEngine_t *engine, const SkimPredicate_t &pred);
+  ~SkimWorker_t() { delete FPredicate; }
+  int status() const { return FStatus; }
+  // processes the input files until none is left
+  void run();
+  int processFile(UInt_t ifile);
+};
+
+// --------------------------------------------------------------
+
+class SkimEngine_t {
+  friend class SkimWorker_t;
+protected:
+  const SkimPredicate_t &FPredicate;
+  UInt_t FOutputBranches, FFetchBranches;
+  Bool_t FWriteOrigNumEntries, FKeepRejected;
+  std::vector<TString> FInFileNames, FPartFileNames;
+  std::vector<ULong64_t> FInputEvts, FPassEvts, FOrigNumEntries;
+  UInt_t FNextFile;
+public:
+  // outputBranches: mask of the branches of the output tree. The fetch
+  // mask is the set of branches read for the accepted events in addition
+  // to the ones of the predicate. If writeOrigNumEntries is false,
+  // origNumEntries=0 is stored and the cross section is not rescaled.
+  // If keepRejected is true, the rejected events are written with the
+  // Info and Gen branches of the output and with empty arrays
+  SkimEngine_t(const SkimPredicate_t &pred, UInt_t outputBranches, UInt_t fetchBranches, Bool_t writeOrigNumEntries=kTRUE, Bool_t keepRejected=kFALSE);
+
+  ULong64_t inputEvents() const;
+  ULong64_t passedEvents() const;
+
+  // returns 1 on success
+  int run(const std::vector<TString> &inFileNames, const TString &outFileName, int nWorkers=1, const std::vector<std::string> *description=NULL);
+
+protected:
+  // index of the next input file, or -1
+  int takeFile();
+  int mergeParts(const TString &outFileName, const std::vector<std::string> *description);
+};
+
+// --------------------------------------------------------------
+
+#endif
@@ -2,6 +2,8 @@
 # This file is an example of skimming and trimming.
 # Before doing it, one has to carefully check all the input configs.
 # The files below ARE NOT a full set
+# The skim/trim macros take the number of input files processed in
+# parallel as the second argument, e.g. SkimNtuples.C+\(\"skim.input\",4\)
 
 #root -l -b -q SkimNtuples.C+\(\"../config_files/skim_configs/skim.input.data1\"\) >& log-skim-data1_wReg.txt 
 #root -l -b -q SkimNtuples.C+\(\"../config_files/skim_configs/skim.input.data2\"\) >& log-skim-data2_wReg.txt 
@@ -52,6 +52,20 @@ doFsrStudy=0
 doResolutionStudy=0
 doCalcUnfoldingSyst=1
 
+# number of makeUnfoldingMatrix.C jobs running at the same time.
+# The completed jobs are recorded in dir-farm-unfoldingSyst and are
+# not repeated if the script is restarted
+nParallelJobs=4
+
+# errors on the inverted response matrix: number of smeared matrices
+# (0 - first-order error propagation) and threads per job. The cores
+# are shared by the parallel jobs
+nInvMatrixErrToys=10000
+nCPUs=`nproc 2>/dev/null`
+if [ ${#nCPUs} -eq 0 ] ; then nCPUs=${nParallelJobs}; fi
+nInvMatrixErrThreads=$(( ${nCPUs} / ${nParallelJobs} ))
+if [ ${nInvMatrixErrThreads} -lt 1 ] ; then nInvMatrixErrThreads=1; fi
+
 #
 #  Modify flags if fullRun=1
 #
@@ -65,25 +79,34 @@ fi
 #
 noError=1
 
+. ../FullChain/jobFarm.sh
+
 # --------------------------------
 #    Define functions to run
 # --------------------------------
 
 runPlotDYUnfoldingMatrix() {
   loc_massLimit=-1
-  root -b -q -l ${LXPLUS_CORRECTION} makeUnfoldingMatrix.C+\(\"${mcConfInputFile}\",\"${triggerSet}\",${StudyFlag},${RandomSeed},${ReweightFsr},${loc_massLimit},${debugMode}\)
+  root -b -q -l ${LXPLUS_CORRECTION} makeUnfoldingMatrix.C+\(\"${mcConfInputFile}\",\"${triggerSet}\",${StudyFlag},${RandomSeed},${ReweightFsr},${loc_massLimit},${debugMode},${nInvMatrixErrToys},${nInvMatrixErrThreads}\)
   if [ $? != 0 ] ; then noError=0;
   else 
      echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
      echo 
-     echo "DONE: makeUnfoldingMatrix.C(\"${mcConfInputFile}\",\"${triggerSet}\",${StudyFlag},${RandomSeed},${ReweightFsr},${loc_massLimit},debug=${debugMode})"
+     echo "DONE: makeUnfoldingMatrix.C(\"${mcConfInputFile}\",\"${triggerSet}\",${StudyFlag},${RandomSeed},${ReweightFsr},${loc_massLimit},debug=${debugMode},toys=${nInvMatrixErrToys},threads=${nInvMatrixErrThreads})"
      echo 
      echo "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD"
   fi
 }
 
+# returns an error code, as needed for farmSubmit
+runPlotDYUnfoldingMatrixTask() {
+  runPlotDYUnfoldingMatrix
+  if [ ${noError} -eq 1 ] ; then return 0; fi
+  return 1
+}
+
 #info:
-# // void makeUnfoldingMatrix(const TString input, int systematicsMode = 0, int randomSeed = 1, double reweightFsr = 1.00, double massLimit = -1)
+# // void makeUnfoldingMatrix(const TString input, const TString triggerSetString, int systematicsMode = 0, int randomSeed = 1, double reweightFsr = 1.00, double massLimit = -1, int debugMode = 0, int nInvMatrixErrToys = 10000, int nInvMatrixErrThreads = 4)
 # // systematicsMode 0 - no systematic calc, no reweighting
 # // 1 - systematic mode, 2 - (reweighting of mass diff < -1 GeV) mode
 #  //check mass spectra with reweight = 95%; 100%; 105%  
@@ -133,13 +156,19 @@ xsecConfInputFile=${storeXSecConfInputFile}
 #   Calculations
 #
 
+#  The tasks are independent and are run concurrently. The macro
+#  was compiled by the debug run above
+#
+
+if [ ${noError} -eq 1 ] ; then
+  farmInit unfoldingSyst ${nParallelJobs}
+fi
+
 if [ ${doFsrStudy} -eq 1 ] && [ ${noError} -eq 1 ] ; then
   StudyFlag="DYTools::FSR_STUDY"; RandomSeed=1
   loopReweightFsr="1.05 0.95"
   for ReweightFsr in ${loopReweightFsr} ; do
-    if [ ${noError} -eq 1 ] ; then
-      runPlotDYUnfoldingMatrix
-    fi
+    farmSubmit fsr_${ReweightFsr} runPlotDYUnfoldingMatrixTask
   done
 fi
 
@@ -150,11 +179,16 @@ if [ ${doResolutionStudy} -eq 1 ] && [ ${noError} -eq 1 ] ; then
   i=0
   while [ ${i} -le 20 ] ; do
       RandomSeed=$(( 1000 + $i ))
-      runPlotDYUnfoldingMatrix
+      farmSubmit resolution_seed${RandomSeed} runPlotDYUnfoldingMatrixTask
       i=$(( $i + 1 ))
   done
 fi
 
+if [ ${noError} -eq 1 ] ; then
+  farmWait
+  if [ $? != 0 ] ; then noError=0; fi
+fi
+
 if [ ${doCalcUnfoldingSyst} -eq 1 ] && [ ${noError} -eq 1 ] ; then
   runCalcUnfoldingSystematics
 fi